@@ -0,0 +1,18 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+
+layout (std140) uniform Frame {
+    mat4 pv; // projection * view
+    mat4 skyboxPv;
+    vec4 viewPos;
+};
+
+out vec3 color;
+
+// Vertices are already in world space
+void main() {
+    color = aColor;
+    gl_Position = pv * vec4(aPos, 1.0f);
+}
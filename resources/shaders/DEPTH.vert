@@ -0,0 +1,19 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+layout (std140) uniform Frame {
+    mat4 pv; // projection * view
+    mat4 skyboxPv;
+    vec4 viewPos;
+};
+
+layout (std140) uniform Object {
+    mat4 model;
+};
+
+// Declared in every opaque program, shading pass after depth pre-pass relies on matching depth exactly
+invariant gl_Position;
+
+void main() {
+    gl_Position = pv * (model * vec4(aPos, 1.0f));
+}
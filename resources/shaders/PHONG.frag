@@ -1,6 +1,20 @@
 #version 330 core
 out vec4 FragColor;
 
+// Variant defines are inserted by ShaderVariants, defaults keep the file compilable on its own
+#ifndef DIR_LIGHTS
+#define DIR_LIGHTS 1
+#endif
+#ifndef POINT_LIGHTS
+#define POINT_LIGHTS 1
+#endif
+#ifndef SPOT_LIGHTS
+#define SPOT_LIGHTS 0
+#endif
+#ifndef SPECULAR_MAP
+#define SPECULAR_MAP 1
+#endif
+
 struct Material {
     sampler2D diffuse;
     sampler2D specular;
@@ -42,39 +56,129 @@ struct SpotLight {
     vec3 specular;
 };
 
-#define NR_POINT_LIGHTS 4
-
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
 
-uniform vec3 viewPos;
-uniform DirLight dirLight;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform SpotLight spotLight;
+layout (std140) uniform Frame {
+    mat4 pv; // projection * view
+    mat4 skyboxPv;
+    vec4 viewPos;
+};
+
+#if DIR_LIGHTS > 0
+uniform DirLight dirLights[DIR_LIGHTS];
+#endif
+#if SPOT_LIGHTS > 0
+uniform SpotLight spotLights[SPOT_LIGHTS];
+#endif
 uniform Material material;
 
+#if POINT_LIGHTS
+// Point lights assigned to clusters of view frustum, see LightClusters
+uniform samplerBuffer clusterLights;    // 4 texels per light
+uniform usamplerBuffer clusterGrid;     // offset and count of every cluster
+uniform usamplerBuffer clusterIndices;  // light indices clusters point into
+uniform vec4 clusterScale;              // tiles per pixel in x and y, slice scale and bias
+uniform vec2 clusterDepth;              // near and far plane
+uniform vec4 clusterSize;               // tiles in x and y, slices
+
+uvec2 ClusterRange();
+PointLight FetchPointLight(uint index);
+#endif
+
+// material colors are sampled once per fragment, not once per light
+vec3 albedo;
+vec3 specularColor;
+
+float SpecularFactor(vec3 lightDir, vec3 normal, vec3 viewDir);
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 
 void main() {
+    // sampled even without diffuse map, texture left on its unit stays the fallback as before variants
+    albedo = vec3(texture(material.diffuse, TexCoords));
+#if SPECULAR_MAP
+    specularColor = vec3(texture(material.specular, TexCoords));
+#else
+    specularColor = vec3(0.0f);
+#endif
+
     vec3 norm = normalize(Normal);
-    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 viewDir = normalize(viewPos.xyz - FragPos);
 
     vec3 result = vec3(0.0f, 0.0f, 0.0f);
 
-    result = CalcDirLight(dirLight, norm, viewDir);
+#if DIR_LIGHTS > 0
+    for (int i = 0; i < DIR_LIGHTS; i++) {
+        result += CalcDirLight(dirLights[i], norm, viewDir);
+    }
+#endif
 
-    for(int i = 0; i < NR_POINT_LIGHTS; i++) {
-        result  += CalcPointLight(pointLights[i], norm, FragPos, viewDir);
+#if POINT_LIGHTS
+    uvec2 range = ClusterRange();
+    for (uint i = 0u; i < range.y; i++) {
+        uint index = texelFetch(clusterIndices, int(range.x + i)).r;
+        result += CalcPointLight(FetchPointLight(index), norm, FragPos, viewDir);
     }
+#endif
 
-    result += CalcSpotLight(spotLight, norm, FragPos, viewDir);
+#if SPOT_LIGHTS > 0
+    for (int i = 0; i < SPOT_LIGHTS; i++) {
+        result += CalcSpotLight(spotLights[i], norm, FragPos, viewDir);
+    }
+#endif
 
     FragColor = vec4(result, 1.0f);
 }
 
+#if POINT_LIGHTS
+// offset and count of lights in cluster of the fragment
+uvec2 ClusterRange() {
+    // view depth from window depth of perspective projection
+    float n = clusterDepth.x;
+    float f = clusterDepth.y;
+    float ndc = gl_FragCoord.z * 2.0f - 1.0f;
+    float depth = 2.0f * n * f / (f + n - ndc * (f - n));
+
+    ivec3 size = ivec3(clusterSize.xyz);
+    ivec2 tile = clamp(ivec2(gl_FragCoord.xy * clusterScale.xy), ivec2(0), size.xy - 1);
+    int slice = clamp(int(floor(log(depth) * clusterScale.z + clusterScale.w)), 0, size.z - 1);
+
+    int cluster = (slice * size.y + tile.y) * size.x + tile.x;
+    return texelFetch(clusterGrid, cluster).rg;
+}
+
+PointLight FetchPointLight(uint index) {
+    int texel = int(index) * 4;
+    vec4 position = texelFetch(clusterLights, texel);
+    vec4 ambient = texelFetch(clusterLights, texel + 1);
+    vec4 diffuse = texelFetch(clusterLights, texel + 2);
+    vec4 specular = texelFetch(clusterLights, texel + 3);
+
+    PointLight light;
+    light.position = position.xyz;
+    light.ambient = ambient.rgb;
+    light.constant = ambient.a;
+    light.diffuse = diffuse.rgb;
+    light.linear = diffuse.a;
+    light.specular = specular.rgb;
+    light.quadratic = specular.a;
+    return light;
+}
+#endif
+
+// specular highlight, not computed at all without specular map
+float SpecularFactor(vec3 lightDir, vec3 normal, vec3 viewDir) {
+#if SPECULAR_MAP
+    vec3 reflectDir = reflect(-lightDir, normal);
+    return pow(max(dot(viewDir, reflectDir), 0.0f), material.shininess);
+#else
+    return 0.0f;
+#endif
+}
+
 // calculates the color when using a directional light.
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir) {
     vec3 lightDir = normalize(-light.direction);
@@ -83,13 +187,12 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir) {
     float diff = max(dot(normal, lightDir), 0.0f);
 
     // specular shading
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0f), material.shininess);
+    float spec = SpecularFactor(lightDir, normal, viewDir);
 
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
-    vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+    vec3 ambient = light.ambient * albedo;
+    vec3 diffuse = light.diffuse * diff * albedo;
+    vec3 specular = light.specular * spec * specularColor;
     return (ambient + diffuse + specular);
 }
 
@@ -101,8 +204,7 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir) {
     float diff = max(dot(normal, lightDir), 0.0f);
 
     // specular shading
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0f), material.shininess);
+    float spec = SpecularFactor(lightDir, normal, viewDir);
 
     // attenuation
     float distance = length(light.position - fragPos);
@@ -113,9 +215,9 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir) {
     }
 
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
-    vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+    vec3 ambient = light.ambient * albedo;
+    vec3 diffuse = light.diffuse * diff * albedo;
+    vec3 specular = light.specular * spec * specularColor;
     ambient *= attenuation;
     diffuse *= attenuation;
     specular *= attenuation;
@@ -130,8 +232,7 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir) {
     float diff = max(dot(normal, lightDir), 0.0f);
 
     // specular shading
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0f), material.shininess);
+    float spec = SpecularFactor(lightDir, normal, viewDir);
 
     // attenuation
     float distance = length(light.position - fragPos);
@@ -147,9 +248,9 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir) {
     float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0f, 1.0f);
 
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
-    vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+    vec3 ambient = light.ambient * albedo;
+    vec3 diffuse = light.diffuse * diff * albedo;
+    vec3 specular = light.specular * spec * specularColor;
     ambient *= attenuation * intensity;
     diffuse *= attenuation * intensity;
     specular *= attenuation * intensity;
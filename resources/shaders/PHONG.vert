@@ -1,19 +1,42 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
+layout (location = 1) in vec4 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
-uniform mat4 model;
-uniform mat4 pv; // projection * view
+layout (std140) uniform Frame {
+    mat4 pv; // projection * view
+    mat4 skyboxPv;
+    vec4 viewPos;
+};
+
+layout (std140) uniform Object {
+    mat4 model;
+};
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
 
+// Compact meshes store octahedral normal in xy with w zero, full normal gets default w of one
+vec3 DecodeNormal(vec4 normal) {
+    if (normal.w > 0.5f) {
+        return normal.xyz;
+    }
+    
+    vec3 n = vec3(normal.xy, 1.0f - abs(normal.x) - abs(normal.y));
+    if (n.z < 0.0f) {
+        n.xy = (1.0f - abs(n.yx)) * mix(vec2(-1.0f), vec2(1.0f), step(0.0f, n.xy));
+    }
+    return normalize(n);
+}
+
+invariant gl_Position;
+
 void main() {
-    FragPos = vec3(model * vec4(aPos, 1.0f));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    vec4 worldPos = model * vec4(aPos, 1.0f);
+    FragPos = vec3(worldPos);
+    Normal = mat3(transpose(inverse(model))) * DecodeNormal(aNormal);
     TexCoords = aTexCoords;
     
-    gl_Position = pv * vec4(FragPos, 1.0f);
+    gl_Position = pv * worldPos;
 }
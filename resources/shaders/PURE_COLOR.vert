@@ -3,12 +3,21 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aColor;
 
-uniform mat4 model;
-uniform mat4 pv; // projection * view
+layout (std140) uniform Frame {
+    mat4 pv; // projection * view
+    mat4 skyboxPv;
+    vec4 viewPos;
+};
+
+layout (std140) uniform Object {
+    mat4 model;
+};
 
 out vec3 color;
 
+invariant gl_Position;
+
 void main() {
     color = aColor;
-    gl_Position = pv * model * vec4(aPos, 1.0f);
+    gl_Position = pv * (model * vec4(aPos, 1.0f));
 }
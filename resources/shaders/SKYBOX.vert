@@ -3,11 +3,15 @@ layout (location = 0) in vec3 aPos;
 
 out vec3 TexCoords;
 
-uniform mat4 pv;
+layout (std140) uniform Frame {
+    mat4 pv; // projection * view
+    mat4 skyboxPv;
+    vec4 viewPos;
+};
 
 void main() {
     TexCoords = aPos;
-    vec4 pos = pv * vec4(aPos, 1.0f);
+    vec4 pos = skyboxPv * vec4(aPos, 1.0f);
     
     gl_Position = pos.xyww;
 }
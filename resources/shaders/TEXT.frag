@@ -0,0 +1,12 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D atlas;
+uniform vec4 color;
+
+void main() {
+    // Font atlas is white, glyph coverage is in alpha
+    FragColor = vec4(color.rgb, color.a * texture(atlas, TexCoords).a);
+}
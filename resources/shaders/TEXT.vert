@@ -0,0 +1,13 @@
+#version 330 core
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec2 aTexCoords;
+
+uniform mat4 projection; // window pixels to clip space
+
+out vec2 TexCoords;
+
+void main() {
+    TexCoords = aTexCoords;
+
+    gl_Position = projection * vec4(aPos, 0.0f, 1.0f);
+}
@@ -15,9 +15,11 @@ void DirectionalLight::Destroy() {
     Object().Scene().UnregisterLightSource(this);
 }
 
-void DirectionalLight::SetLightProperties(const ShaderProgram& shader) {
-    shader.Uniform("dirLight.direction", m_Direction);
-    shader.Uniform("dirLight.ambient", m_Ambient);
-    shader.Uniform("dirLight.diffuse", m_Diffuse);
-    shader.Uniform("dirLight.specular", m_Specular);
+void DirectionalLight::SetLightProperties(const ShaderProgram& shader, unsigned int index) {
+    std::string dir_light = "dirLights[" + std::to_string(index) + "].";
+
+    shader.Uniform(dir_light + "direction", m_Direction);
+    shader.Uniform(dir_light + "ambient", m_Ambient);
+    shader.Uniform(dir_light + "diffuse", m_Diffuse);
+    shader.Uniform(dir_light + "specular", m_Specular);
 }
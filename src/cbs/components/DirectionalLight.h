@@ -12,7 +12,8 @@ public:
     void Initialize() override;
     void Destroy() override;
 
-    void SetLightProperties(const ShaderProgram& shader) override;
+    Kind LightKind() const override { return Kind::DIRECTIONAL; }
+    void SetLightProperties(const ShaderProgram& shader, unsigned int index) override;
 
 private:
     glm::vec3 m_Direction;
@@ -1,82 +1,105 @@
 #include "Mesh.h"
 
+#include "../../../rendering/GLState.h"
+
+#include <algorithm>
+
 Mesh::Mesh(const std::vector<Vertex> &verticies, const std::vector<unsigned int> &indicies, const std::vector<Texture> &textures)
-    : m_Vertices(verticies)
-    , m_Indices(indicies)
+    : m_IndexCount(indicies.size())
+    , m_IndexType(GL_UNSIGNED_INT)
+    , m_Lods{ MeshLod{ 0, indicies.size(), 0.0f } }
     , m_Textures(textures) {
-    SetupMesh();
-}
+    for (const Vertex& vertex : verticies) {
+        m_Bounds.Extend(vertex.Position);
+    }
 
-Mesh::Mesh(Mesh&& other) noexcept
-    : m_Vertices(std::move(other.m_Vertices))
-    , m_Indices(std::move(other.m_Indices))
-    , m_Textures(std::move(other.m_Textures))
-    , m_VAO(other.m_VAO)
-    , m_VBO(other.m_VBO)
-    , m_EBO(other.m_EBO) {
-    other.m_VAO = 0;
-    other.m_VBO = 0;
-    other.m_EBO = 0;
+    SetupMesh(verticies.data(), verticies.size(), VertexLayout::Full, indicies.data());
 }
 
-Mesh& Mesh::operator=(Mesh&& other) noexcept {
-    m_Vertices = std::move(other.m_Vertices);
-    m_Indices = std::move(other.m_Indices);
-    m_Textures = std::move(other.m_Textures);
-    std::swap(m_VAO, other.m_VAO);
-    std::swap(m_VBO, other.m_VBO);
-    std::swap(m_EBO, other.m_EBO);
-
-    return *this;
-}
+Mesh::Mesh(const void *vertices, std::size_t vertex_count, VertexLayout layout, const void *indices, std::size_t index_count, GLenum index_type,
+           const std::vector<MeshLod> &lods, const AABB &bounds, const std::vector<Texture> &textures)
+    : m_IndexCount(index_count)
+    , m_IndexType(index_type)
+    , m_Lods(lods)
+    , m_Textures(textures)
+    , m_Bounds(bounds) {
+    if (m_Lods.empty()) {
+        m_Lods.push_back({ 0, index_count, 0.0f });
+    }
 
-Mesh::~Mesh() {
-    glDeleteVertexArrays(1, &m_VAO);
-    glDeleteBuffers(1, &m_VBO);
-    glDeleteBuffers(1, &m_EBO);
+    SetupMesh(vertices, vertex_count, layout, indices);
 }
 
-void Mesh::Draw(const ShaderProgram &shader) const {
+void Mesh::Draw(const ShaderProgram &shader, std::size_t lod) const {
     for (GLuint i = 0; i < m_Textures.size(); i++) {
-        glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(i));
-        
         shader.Uniform("material." + m_Textures[i].Type, static_cast<int>(i));
-        glBindTexture(GL_TEXTURE_2D, m_Textures[i].ID);
+        g_GLState.BindTexture(i, GL_TEXTURE_2D, m_Textures[i].ID);
     }
     
-    glBindVertexArray(m_VAO);
-    glDrawElements(GL_TRIANGLES, (int)m_Indices.size(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    g_GLState.BindVertexArray(m_VAO.ID());
+    const MeshLod& level = m_Lods[std::min(lod, m_Lods.size() - 1)];
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(level.IndexCount), m_IndexType, (void *)(level.IndexOffset * IndexSize(m_IndexType)));
     
-    glActiveTexture(GL_TEXTURE0);
+    g_GLState.ActiveTexture(GL_TEXTURE0);
+}
+
+unsigned int Mesh::Maps() const {
+    unsigned int maps = ShaderVariants::NO_MAPS;
+    for (const Texture& texture : m_Textures) {
+        if (texture.Type == "diffuse") {
+            maps |= ShaderVariants::DIFFUSE_MAP;
+        } else if (texture.Type == "specular") {
+            maps |= ShaderVariants::SPECULAR_MAP;
+        }
+    }
+
+    return maps;
 }
 
-void Mesh::SetupMesh() {
-    glGenVertexArrays(1, &m_VAO);
-    glGenBuffers(1, &m_VBO);
-    glGenBuffers(1, &m_EBO);
+std::size_t Mesh::Stride(VertexLayout layout) {
+    return layout == VertexLayout::Compact ? sizeof(CompactVertex) : sizeof(Vertex);
+}
+
+std::size_t Mesh::IndexSize(GLenum index_type) {
+    return index_type == GL_UNSIGNED_SHORT ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+}
+
+void Mesh::SetupMesh(const void *vertices, std::size_t vertex_count, VertexLayout layout, const void *indices) {
+    m_VAO = VertexArrayHandle::Create(GLResources::Owner::MESHES);
+    m_VBO = BufferHandle::Create(GLResources::Owner::MESHES);
+    m_EBO = BufferHandle::Create(GLResources::Owner::MESHES);
     
-    glBindVertexArray(m_VAO);
+    g_GLState.BindVertexArray(m_VAO.ID());
     
-    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-    glBufferData(GL_ARRAY_BUFFER, m_Vertices.size() * sizeof(Vertex), &m_Vertices[0], GL_STATIC_DRAW);
+    GLsizei stride = static_cast<GLsizei>(Stride(layout));
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO.ID());
+    glBufferData(GL_ARRAY_BUFFER, vertex_count * stride, vertices, GL_STATIC_DRAW);
+    m_VBO.Bytes(vertex_count * stride);
     
-    // Position
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)0);
+    switch (layout) {
+    case VertexLayout::Full:
+        // Position
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void *)0);
+        // Normal vectors
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(Vertex, Normal));
+        // Texture coords
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(Vertex, TexCoords));
+        break;
+    case VertexLayout::Compact:
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void *)0);
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void *)offsetof(CompactVertex, Normal));
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void *)offsetof(CompactVertex, TexCoords));
+        break;
+    }
     glEnableVertexAttribArray(0);
-    
-    // Normal vectors
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, Normal));
     glEnableVertexAttribArray(1);
-    
-    // Texture coords
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, TexCoords));
     glEnableVertexAttribArray(2);
     
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_Indices.size() * sizeof(unsigned int), &m_Indices[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO.ID());
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_IndexCount * IndexSize(m_IndexType), indices, GL_STATIC_DRAW);
+    m_EBO.Bytes(m_IndexCount * IndexSize(m_IndexType));
     
-    glBindVertexArray(0);
+    g_GLState.BindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
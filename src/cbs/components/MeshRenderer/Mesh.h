@@ -2,6 +2,9 @@
 #define Mesh_h
 
 #include "../../../rendering/ShaderProgram.h"
+#include "../../../rendering/ShaderVariants.h"
+#include "../../../rendering/Bounds.h"
+#include "../../../rendering/GLResources.h"
 
 #pragma warning(push, 0)
 #include <glad/glad.h>
@@ -11,6 +14,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 #pragma warning(pop)
 
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -21,39 +26,78 @@ struct Vertex {
     glm::vec2 TexCoords;
 };
 
+// Normal is octahedral encoded into x and y of GL_INT_2_10_10_10_REV with w left zero,
+// vertex shader tells it apart from full normal whose w defaults to one
+struct CompactVertex {
+    glm::vec3 Position;
+    std::uint32_t Normal;
+    std::uint16_t TexCoords[2];    // Half floats
+};
+
+static_assert(sizeof(CompactVertex) == 20, "CompactVertex has to be tightly packed");
+
+enum class VertexLayout {
+    Full,       // Vertex
+    Compact,    // CompactVertex
+};
+
+// Range of index buffer drawing one level of detail, coarser levels reuse the vertices
+struct MeshLod {
+    std::size_t IndexOffset{ 0 };    // In indices
+    std::size_t IndexCount{ 0 };
+    float Error{ 0.0f };              // Largest deviation from full level, in model units
+};
+
 struct Texture {
     GLuint ID = 0;
     std::string Type;
     std::string Path;
 };
 
+// Geometry lives only in GPU buffers, vertices are not kept on CPU after upload
 class Mesh {
 public:
     Mesh(const std::vector<Vertex> &verticies, const std::vector<unsigned int> &indicies, const std::vector<Texture> &textures);
+    // Uploads vertex and index data straight from memory, e.g. mapped cache file. Without
+    // levels of detail all indices draw single level
+    Mesh(const void *vertices, std::size_t vertex_count, VertexLayout layout, const void *indices, std::size_t index_count, GLenum index_type,
+         const std::vector<MeshLod> &lods, const AABB &bounds, const std::vector<Texture> &textures);
     Mesh() = delete;
     Mesh(const Mesh&) = delete;
     Mesh& operator=(const Mesh&) = delete;
-    Mesh(Mesh&& other) noexcept;
-    Mesh& operator=(Mesh&& other) noexcept;
-    ~Mesh();
+    Mesh(Mesh&& other) noexcept = default;
+    Mesh& operator=(Mesh&& other) noexcept = default;
+    ~Mesh() = default;
+
+    // Level past the last one draws the last one
+    void Draw(const ShaderProgram &shader, std::size_t lod = 0) const;
 
-    void Draw(const ShaderProgram &shader) const;
+    std::size_t IndexCount() const { return m_IndexCount; }
 
-    const std::vector<Vertex>& Vertices() const { return m_Vertices; }
+    GLenum IndexType() const { return m_IndexType; }
 
-    const std::vector<unsigned int>& Indicies() const { return m_Indices; }
+    const std::vector<MeshLod>& Lods() const { return m_Lods; }
 
     const std::vector<Texture>& Textures() const { return m_Textures; }
+    // ShaderVariants::Map bits of the textures
+    unsigned int Maps() const;
+
+    const AABB& Bounds() const { return m_Bounds; }
+
+    static std::size_t Stride(VertexLayout layout);
+    static std::size_t IndexSize(GLenum index_type);
 
 private:
-    void SetupMesh();
+    void SetupMesh(const void *vertices, std::size_t vertex_count, VertexLayout layout, const void *indices);
 
-    std::vector<Vertex> m_Vertices;
-    std::vector<unsigned int> m_Indices;
+    std::size_t m_IndexCount;
+    GLenum m_IndexType;
+    std::vector<MeshLod> m_Lods;
     std::vector<Texture> m_Textures;
-    GLuint m_VAO;
-    GLuint m_VBO;
-    GLuint m_EBO;
+    AABB m_Bounds;
+    VertexArrayHandle m_VAO;
+    BufferHandle m_VBO;
+    BufferHandle m_EBO;
 };
 
 #endif
@@ -0,0 +1,218 @@
+#include "MeshCache.h"
+
+#include "../../../utilities/Hash.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+std::uint64_t MeshCache::Key(const std::string& path, VertexLayout layout) {
+    std::uint64_t hash = Fnv1a(path);
+
+    std::uint64_t format[] = { VERSION, static_cast<std::uint64_t>(layout), Mesh::Stride(layout) };
+    hash = Fnv1a(format, sizeof(format), hash);
+
+    std::error_code error;
+    std::uint64_t size = std::filesystem::file_size(path, error);
+    std::int64_t time = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+    hash = Fnv1a(&size, sizeof(size), hash);
+    hash = Fnv1a(&time, sizeof(time), hash);
+
+    return hash;
+}
+
+std::string MeshCache::Path(std::uint64_t key) {
+    return std::string(DIRECTORY) + "/" + HashToHex(key) + ".mesh";
+}
+
+bool MeshCache::Parse(const MappedFile& file, VertexLayout layout, std::vector<MeshView>* meshes) {
+    if (file.Size() < sizeof(Header)) {
+        return false;
+    }
+
+    Header header;
+    std::memcpy(&header, file.Data(), sizeof(Header));
+    if (header.Magic != MAGIC || header.Version != VERSION || header.Layout != static_cast<std::uint32_t>(layout)) {
+        return false;
+    }
+
+    // Tables are counted in 32 bits, so offset cannot wrap once strings fit in the file
+    if (header.StringsSize > file.Size()) {
+        return false;
+    }
+    std::size_t blob_offset = BlobOffset(header.Meshes, header.Lods, header.Textures, header.StringsSize);
+    if (blob_offset > file.Size() || header.VerticesSize > file.Size() - blob_offset
+        || header.IndicesSize > file.Size() - blob_offset - header.VerticesSize) {
+        return false;
+    }
+
+    const unsigned char* entries = file.Data() + sizeof(Header);
+    const unsigned char* lod_entries = entries + header.Meshes * sizeof(MeshEntry);
+    const unsigned char* texture_entries = lod_entries + header.Lods * sizeof(LodEntry);
+    const char* strings = reinterpret_cast<const char*>(texture_entries + header.Textures * sizeof(TextureEntry));
+    const unsigned char* vertices = file.Data() + blob_offset;
+    const unsigned char* indices = vertices + header.VerticesSize;
+
+    std::size_t stride = Mesh::Stride(layout);
+    meshes->clear();
+    meshes->reserve(header.Meshes);
+    for (std::uint32_t i = 0; i < header.Meshes; i++) {
+        MeshEntry entry;
+        std::memcpy(&entry, entries + i * sizeof(MeshEntry), sizeof(MeshEntry));
+        // Limits are subtracted rather than products added, so huge counts cannot wrap around
+        if ((entry.IndexType != GL_UNSIGNED_SHORT && entry.IndexType != GL_UNSIGNED_INT)
+            || entry.VertexOffset > header.VerticesSize
+            || entry.VertexCount > (header.VerticesSize - entry.VertexOffset) / stride
+            || entry.IndexOffset > header.IndicesSize
+            || entry.IndexCount > (header.IndicesSize - entry.IndexOffset) / Mesh::IndexSize(entry.IndexType)
+            || static_cast<std::uint64_t>(entry.LodBegin) + entry.LodCount > header.Lods
+            || static_cast<std::uint64_t>(entry.TextureBegin) + entry.TextureCount > header.Textures) {
+            return false;
+        }
+        if (!IndicesInRange(indices + entry.IndexOffset, static_cast<std::size_t>(entry.IndexCount), entry.IndexType,
+                            static_cast<std::size_t>(entry.VertexCount))) {
+            return false;
+        }
+
+        MeshView mesh;
+        mesh.Vertices = vertices + entry.VertexOffset;
+        mesh.VertexCount = static_cast<std::size_t>(entry.VertexCount);
+        mesh.Indices = indices + entry.IndexOffset;
+        mesh.IndexCount = static_cast<std::size_t>(entry.IndexCount);
+        mesh.IndexType = entry.IndexType;
+
+        for (std::uint32_t j = entry.LodBegin; j < entry.LodBegin + entry.LodCount; j++) {
+            LodEntry lod;
+            std::memcpy(&lod, lod_entries + j * sizeof(LodEntry), sizeof(LodEntry));
+            if (lod.IndexOffset > entry.IndexCount || lod.IndexCount > entry.IndexCount - lod.IndexOffset) {
+                return false;
+            }
+
+            mesh.Lods.push_back({ static_cast<std::size_t>(lod.IndexOffset), static_cast<std::size_t>(lod.IndexCount), lod.Error });
+        }
+        mesh.Bounds = AABB(glm::vec3(entry.Min[0], entry.Min[1], entry.Min[2]), glm::vec3(entry.Max[0], entry.Max[1], entry.Max[2]));
+
+        for (std::uint32_t j = entry.TextureBegin; j < entry.TextureBegin + entry.TextureCount; j++) {
+            TextureEntry texture;
+            std::memcpy(&texture, texture_entries + j * sizeof(TextureEntry), sizeof(TextureEntry));
+            if (static_cast<std::uint64_t>(texture.TypeOffset) + texture.TypeLength > header.StringsSize
+                || static_cast<std::uint64_t>(texture.PathOffset) + texture.PathLength > header.StringsSize) {
+                return false;
+            }
+
+            mesh.Textures.push_back({ std::string(strings + texture.TypeOffset, texture.TypeLength),
+                                      std::string(strings + texture.PathOffset, texture.PathLength) });
+        }
+
+        meshes->push_back(std::move(mesh));
+    }
+
+    return true;
+}
+
+void MeshCache::Store(std::uint64_t key, VertexLayout layout, const std::vector<MeshData>& meshes) {
+    std::vector<MeshEntry> entries;
+    std::vector<LodEntry> lod_entries;
+    std::vector<TextureEntry> texture_entries;
+    std::string strings;
+    std::uint64_t vertices_size = 0;
+    std::uint64_t indices_size = 0;
+
+    for (const MeshData& mesh : meshes) {
+        MeshEntry entry{};
+        entry.VertexOffset = vertices_size;
+        entry.VertexCount = mesh.VertexCount;
+        entry.IndexOffset = indices_size;
+        entry.IndexCount = mesh.IndexCount;
+        entry.IndexType = mesh.IndexType;
+        entry.LodBegin = static_cast<std::uint32_t>(lod_entries.size());
+        entry.LodCount = static_cast<std::uint32_t>(mesh.Lods.size());
+        entry.TextureBegin = static_cast<std::uint32_t>(texture_entries.size());
+        entry.TextureCount = static_cast<std::uint32_t>(mesh.Textures.size());
+        for (int i = 0; i < 3; i++) {
+            entry.Min[i] = mesh.Bounds.Min[i];
+            entry.Max[i] = mesh.Bounds.Max[i];
+        }
+        entries.push_back(entry);
+
+        for (const MeshLod& lod : mesh.Lods) {
+            lod_entries.push_back({ lod.IndexOffset, lod.IndexCount, lod.Error, 0 });
+        }
+
+        for (const TextureReference& texture : mesh.Textures) {
+            TextureEntry texture_entry;
+            texture_entry.TypeOffset = static_cast<std::uint32_t>(strings.size());
+            texture_entry.TypeLength = static_cast<std::uint32_t>(texture.Type.size());
+            strings += texture.Type;
+            texture_entry.PathOffset = static_cast<std::uint32_t>(strings.size());
+            texture_entry.PathLength = static_cast<std::uint32_t>(texture.Path.size());
+            strings += texture.Path;
+            texture_entries.push_back(texture_entry);
+        }
+
+        vertices_size += mesh.Vertices.size();
+        indices_size += PaddedIndexSize(mesh.Indices.size());
+    }
+
+    Header header{ MAGIC, VERSION, static_cast<std::uint32_t>(layout), static_cast<std::uint32_t>(entries.size()),
+                   static_cast<std::uint32_t>(texture_entries.size()), static_cast<std::uint32_t>(lod_entries.size()),
+                   strings.size(), vertices_size, indices_size };
+
+    std::error_code error;
+    std::filesystem::create_directories(DIRECTORY, error);
+
+    std::ofstream file(Path(key), std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cout << "Mesh cache failed to save at path: " << Path(key) << '\n';
+        return;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(MeshEntry));
+    file.write(reinterpret_cast<const char*>(lod_entries.data()), lod_entries.size() * sizeof(LodEntry));
+    file.write(reinterpret_cast<const char*>(texture_entries.data()), texture_entries.size() * sizeof(TextureEntry));
+    file.write(strings.data(), strings.size());
+
+    std::size_t written = sizeof(Header) + entries.size() * sizeof(MeshEntry) + lod_entries.size() * sizeof(LodEntry)
+                        + texture_entries.size() * sizeof(TextureEntry) + strings.size();
+    const char padding[BLOB_ALIGNMENT] = {};
+    file.write(padding, BlobOffset(entries.size(), lod_entries.size(), texture_entries.size(), strings.size()) - written);
+
+    for (const MeshData& mesh : meshes) {
+        file.write(reinterpret_cast<const char*>(mesh.Vertices.data()), mesh.Vertices.size());
+    }
+    for (const MeshData& mesh : meshes) {
+        file.write(reinterpret_cast<const char*>(mesh.Indices.data()), mesh.Indices.size());
+        file.write(padding, PaddedIndexSize(mesh.Indices.size()) - mesh.Indices.size());
+    }
+}
+
+std::size_t MeshCache::PaddedIndexSize(std::size_t size) {
+    return (size + INDEX_ALIGNMENT - 1) / INDEX_ALIGNMENT * INDEX_ALIGNMENT;
+}
+
+bool MeshCache::IndicesInRange(const unsigned char* indices, std::size_t count, GLenum type, std::size_t vertex_count) {
+    // Offset in the file need not be aligned, so indices are copied out one by one
+    for (std::size_t i = 0; i < count; i++) {
+        std::uint32_t index;
+        if (type == GL_UNSIGNED_SHORT) {
+            std::uint16_t index16;
+            std::memcpy(&index16, indices + i * sizeof(index16), sizeof(index16));
+            index = index16;
+        } else {
+            std::memcpy(&index, indices + i * sizeof(index), sizeof(index));
+        }
+
+        if (index >= vertex_count) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::size_t MeshCache::BlobOffset(std::size_t meshes, std::size_t lods, std::size_t textures, std::size_t strings_size) {
+    std::size_t offset = sizeof(Header) + meshes * sizeof(MeshEntry) + lods * sizeof(LodEntry) + textures * sizeof(TextureEntry) + strings_size;
+    return (offset + BLOB_ALIGNMENT - 1) / BLOB_ALIGNMENT * BLOB_ALIGNMENT;
+}
@@ -0,0 +1,122 @@
+#ifndef MeshCache_h
+#define MeshCache_h
+
+#include "Mesh.h"
+#include "../../../rendering/Bounds.h"
+#include "../../../utilities/MappedFile.h"
+
+#pragma warning(push, 0)
+#include <glad/glad.h>
+#pragma warning(pop)
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Mesh cache
+ *
+ * Stores imported models in binary form: table of meshes, their levels of
+ * detail and material textures followed by one vertex and one index blob laid out exactly as
+ * they are uploaded, already optimized and packed. Loading is a memory map
+ * and a buffer upload per mesh, Assimp is not involved. Entry is keyed by
+ * path, size and modification time of the source model and by vertex
+ * layout, so an edited model or changed layout simply misses the cache.
+ */
+class MeshCache {
+public:
+    static constexpr const char* DIRECTORY = "cache/meshes";
+
+    struct TextureReference {
+        std::string Type;
+        std::string Path;    // Relative to directory of the model
+    };
+
+    // Mesh as imported and packed, owns its data
+    struct MeshData {
+        std::vector<unsigned char> Vertices;    // In layout of the entry
+        std::size_t VertexCount{ 0 };
+        std::vector<unsigned char> Indices;     // Levels of detail one after another
+        std::size_t IndexCount{ 0 };
+        GLenum IndexType{ GL_UNSIGNED_INT };
+        std::vector<MeshLod> Lods;
+        std::vector<TextureReference> Textures;
+        AABB Bounds;
+    };
+
+    // Mesh stored in mapped file, valid while the file stays mapped
+    struct MeshView {
+        const void* Vertices{ nullptr };
+        std::size_t VertexCount{ 0 };
+        const void* Indices{ nullptr };
+        std::size_t IndexCount{ 0 };
+        GLenum IndexType{ GL_UNSIGNED_INT };
+        std::vector<MeshLod> Lods;
+        std::vector<TextureReference> Textures;
+        AABB Bounds;
+    };
+
+    static std::uint64_t Key(const std::string& path, VertexLayout layout);
+    static std::string Path(std::uint64_t key);
+
+    // Returns false if file is not valid entry, counts and offsets are checked so corrupted file is just a miss
+    static bool Parse(const MappedFile& file, VertexLayout layout, std::vector<MeshView>* meshes);
+    static void Store(std::uint64_t key, VertexLayout layout, const std::vector<MeshData>& meshes);
+
+private:
+    static constexpr std::uint32_t MAGIC = 0x4E49424D;    // "MBIN"
+    static constexpr std::uint32_t VERSION = 3;
+    // Vertex blob starts at multiple of this from the beginning of file
+    static constexpr std::size_t BLOB_ALIGNMENT = 16;
+    // Indices of every mesh start at multiple of this within index blob
+    static constexpr std::size_t INDEX_ALIGNMENT = 4;
+
+    struct Header {
+        std::uint32_t Magic;
+        std::uint32_t Version;
+        std::uint32_t Layout;
+        std::uint32_t Meshes;
+        std::uint32_t Textures;
+        std::uint32_t Lods;
+        std::uint64_t StringsSize;
+        std::uint64_t VerticesSize;
+        std::uint64_t IndicesSize;
+    };
+
+    struct MeshEntry {
+        std::uint64_t VertexOffset;    // In bytes
+        std::uint64_t VertexCount;
+        std::uint64_t IndexOffset;     // In bytes
+        std::uint64_t IndexCount;
+        std::uint32_t IndexType;
+        std::uint32_t LodBegin;
+        std::uint32_t LodCount;
+        std::uint32_t TextureBegin;
+        std::uint32_t TextureCount;
+        float Min[3];
+        float Max[3];
+    };
+
+    struct LodEntry {
+        std::uint64_t IndexOffset;    // In indices
+        std::uint64_t IndexCount;
+        float Error;
+        std::uint32_t Padding;
+    };
+
+    struct TextureEntry {
+        std::uint32_t TypeOffset;
+        std::uint32_t TypeLength;
+        std::uint32_t PathOffset;
+        std::uint32_t PathLength;
+    };
+
+    static std::size_t BlobOffset(std::size_t meshes, std::size_t lods, std::size_t textures, std::size_t strings_size);
+    // Size rounded up to INDEX_ALIGNMENT
+    static std::size_t PaddedIndexSize(std::size_t size);
+    // True if every index refers to one of the vertices
+    static bool IndicesInRange(const unsigned char* indices, std::size_t count, GLenum type, std::size_t vertex_count);
+};
+
+#endif
@@ -0,0 +1,443 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int>* indices, std::size_t vertex_count) {
+    std::size_t triangle_count = indices->size() / 3;
+    if (triangle_count == 0) {
+        return;
+    }
+
+    // Triangles not yet emitted, listed per vertex
+    std::vector<unsigned int> remaining(vertex_count, 0);
+    for (unsigned int index : *indices) {
+        remaining[index]++;
+    }
+    std::vector<std::size_t> offsets(vertex_count + 1, 0);
+    for (std::size_t v = 0; v < vertex_count; v++) {
+        offsets[v + 1] = offsets[v] + remaining[v];
+    }
+    std::vector<unsigned int> adjacency(indices->size());
+    std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+    for (std::size_t i = 0; i < indices->size(); i++) {
+        adjacency[fill[(*indices)[i]]++] = static_cast<unsigned int>(i / 3);
+    }
+
+    std::vector<int> cache_position(vertex_count, -1);
+    std::vector<float> vertex_score(vertex_count);
+    for (std::size_t v = 0; v < vertex_count; v++) {
+        vertex_score[v] = VertexScore(-1, remaining[v]);
+    }
+
+    constexpr std::size_t NONE = std::numeric_limits<std::size_t>::max();
+    std::size_t best = NONE;
+    float best_score = -1.0f;
+    std::vector<float> triangle_score(triangle_count);
+    for (std::size_t t = 0; t < triangle_count; t++) {
+        const unsigned int* triangle = indices->data() + t * 3;
+        triangle_score[t] = vertex_score[triangle[0]] + vertex_score[triangle[1]] + vertex_score[triangle[2]];
+        if (triangle_score[t] > best_score) {
+            best = t;
+            best_score = triangle_score[t];
+        }
+    }
+
+    std::vector<bool> emitted(triangle_count, false);
+    std::vector<unsigned int> cache;
+    std::vector<unsigned int> next_cache;
+    cache.reserve(CACHE_SIZE + 3);
+    next_cache.reserve(CACHE_SIZE + 3);
+    std::vector<unsigned int> result;
+    result.reserve(indices->size());
+    std::size_t cursor = 0;
+
+    while (result.size() < triangle_count * 3) {
+        // No cached vertex has triangles left, continue with the first one not emitted
+        if (best == NONE) {
+            while (emitted[cursor]) {
+                cursor++;
+            }
+            best = cursor;
+        }
+
+        emitted[best] = true;
+        const unsigned int* triangle = indices->data() + best * 3;
+        result.insert(result.end(), triangle, triangle + 3);
+
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = triangle[k];
+            auto begin = adjacency.begin() + offsets[v];
+            auto end = begin + remaining[v];
+            *std::find(begin, end, static_cast<unsigned int>(best)) = *(end - 1);
+            remaining[v]--;
+        }
+
+        // Vertices of the triangle move to the front of LRU cache
+        next_cache.clear();
+        for (int k = 0; k < 3; k++) {
+            if (std::find(next_cache.begin(), next_cache.end(), triangle[k]) == next_cache.end()) {
+                next_cache.push_back(triangle[k]);
+            }
+        }
+        for (unsigned int v : cache) {
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                next_cache.push_back(v);
+            }
+        }
+
+        // Rescore every vertex whose position changed, evicted ones included
+        for (std::size_t i = 0; i < next_cache.size(); i++) {
+            unsigned int v = next_cache[i];
+            cache_position[v] = i < CACHE_SIZE ? static_cast<int>(i) : -1;
+            vertex_score[v] = VertexScore(cache_position[v], remaining[v]);
+        }
+
+        best = NONE;
+        best_score = -1.0f;
+        for (unsigned int v : next_cache) {
+            for (std::size_t i = offsets[v]; i < offsets[v] + remaining[v]; i++) {
+                std::size_t t = adjacency[i];
+                const unsigned int* other = indices->data() + t * 3;
+                triangle_score[t] = vertex_score[other[0]] + vertex_score[other[1]] + vertex_score[other[2]];
+                if (triangle_score[t] > best_score) {
+                    best = t;
+                    best_score = triangle_score[t];
+                }
+            }
+        }
+
+        if (next_cache.size() > CACHE_SIZE) {
+            next_cache.resize(CACHE_SIZE);
+        }
+        std::swap(cache, next_cache);
+    }
+
+    *indices = std::move(result);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>* vertices, std::vector<unsigned int>* indices) {
+    constexpr unsigned int UNUSED = std::numeric_limits<unsigned int>::max();
+    std::vector<unsigned int> remap(vertices->size(), UNUSED);
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertices->size());
+
+    for (unsigned int& index : *indices) {
+        if (remap[index] == UNUSED) {
+            remap[index] = static_cast<unsigned int>(reordered.size());
+            reordered.push_back((*vertices)[index]);
+        }
+        index = remap[index];
+    }
+
+    *vertices = std::move(reordered);
+}
+
+std::vector<unsigned int> MeshOptimizer::Simplify(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                                                  std::size_t target_index_count, float* error) {
+    std::size_t vertex_count = vertices.size();
+    std::size_t triangle_count = indices.size() / 3;
+    std::vector<unsigned int> triangles(indices.begin(), indices.begin() + triangle_count * 3);
+
+    std::vector<Quadric> quadrics(vertex_count);
+    for (std::size_t t = 0; t < triangle_count; t++) {
+        const unsigned int* triangle = triangles.data() + t * 3;
+        const glm::vec3& p0 = vertices[triangle[0]].Position;
+        glm::vec3 normal = glm::cross(vertices[triangle[1]].Position - p0, vertices[triangle[2]].Position - p0);
+        float length = glm::length(normal);
+        if (length <= 0.0f) {
+            continue;
+        }
+
+        normal /= length;
+        Quadric quadric(normal, -glm::dot(normal, p0), length * 0.5f);
+        for (int k = 0; k < 3; k++) {
+            quadrics[triangle[k]] += quadric;
+        }
+    }
+
+    // Edge used by single triangle is on a border, seams are borders too since their vertices are split
+    std::unordered_map<std::uint64_t, unsigned int> edges;
+    for (std::size_t t = 0; t < triangle_count; t++) {
+        for (int k = 0; k < 3; k++) {
+            std::uint64_t a = triangles[t * 3 + k];
+            std::uint64_t b = triangles[t * 3 + (k + 1) % 3];
+            edges[std::min(a, b) << 32 | std::max(a, b)]++;
+        }
+    }
+    std::vector<bool> locked(vertex_count, false);
+    for (const auto& edge : edges) {
+        if (edge.second == 1) {
+            locked[edge.first >> 32] = true;
+            locked[edge.first & 0xFFFFFFFF] = true;
+        }
+    }
+
+    std::vector<std::vector<unsigned int>> adjacent(vertex_count);
+    for (std::size_t i = 0; i < triangles.size(); i++) {
+        adjacent[triangles[i]].push_back(static_cast<unsigned int>(i / 3));
+    }
+
+    std::vector<unsigned int> version(vertex_count, 0);
+    std::vector<bool> collapsed(vertex_count, false);
+    std::vector<bool> removed(triangle_count, false);
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+    auto push = [&](unsigned int from, unsigned int to) {
+        if (locked[from]) {
+            return;
+        }
+
+        Quadric quadric = quadrics[from];
+        quadric += quadrics[to];
+        queue.push({ quadric.Evaluate(vertices[to].Position), from, to, version[from], version[to] });
+    };
+
+    for (std::size_t i = 0; i < triangles.size(); i++) {
+        unsigned int a = triangles[i];
+        unsigned int b = triangles[i - i % 3 + (i + 1) % 3];
+        push(a, b);
+        push(b, a);
+    }
+
+    std::size_t live = triangle_count;
+    double max_cost = 0.0;
+    while (live * 3 > target_index_count && !queue.empty()) {
+        Collapse collapse = queue.top();
+        queue.pop();
+        if (collapsed[collapse.From] || collapsed[collapse.To]
+            || version[collapse.From] != collapse.FromVersion || version[collapse.To] != collapse.ToVersion) {
+            continue;
+        }
+
+        // Moving the vertex must not turn any remaining triangle around
+        const glm::vec3& destination = vertices[collapse.To].Position;
+        bool valid = true;
+        for (unsigned int t : adjacent[collapse.From]) {
+            const unsigned int* triangle = triangles.data() + t * 3;
+            if (removed[t] || triangle[0] == collapse.To || triangle[1] == collapse.To || triangle[2] == collapse.To) {
+                continue;
+            }
+
+            glm::vec3 before[3], after[3];
+            for (int k = 0; k < 3; k++) {
+                before[k] = vertices[triangle[k]].Position;
+                after[k] = triangle[k] == collapse.From ? destination : before[k];
+            }
+            glm::vec3 normal_before = glm::cross(before[1] - before[0], before[2] - before[0]);
+            glm::vec3 normal_after = glm::cross(after[1] - after[0], after[2] - after[0]);
+            if (glm::dot(normal_before, normal_after) <= 0.0f) {
+                valid = false;
+                break;
+            }
+        }
+        if (!valid) {
+            continue;
+        }
+
+        for (unsigned int t : adjacent[collapse.From]) {
+            unsigned int* triangle = triangles.data() + t * 3;
+            if (removed[t]) {
+                continue;
+            }
+
+            if (triangle[0] == collapse.To || triangle[1] == collapse.To || triangle[2] == collapse.To) {
+                removed[t] = true;
+                live--;
+            } else {
+                for (int k = 0; k < 3; k++) {
+                    if (triangle[k] == collapse.From) {
+                        triangle[k] = collapse.To;
+                    }
+                }
+                adjacent[collapse.To].push_back(t);
+            }
+        }
+
+        collapsed[collapse.From] = true;
+        quadrics[collapse.To] += quadrics[collapse.From];
+        version[collapse.To]++;
+        max_cost = std::max(max_cost, collapse.Cost);
+
+        // Quadric of the destination changed, so are costs of its edges
+        for (unsigned int t : adjacent[collapse.To]) {
+            if (removed[t]) {
+                continue;
+            }
+            for (int k = 0; k < 3; k++) {
+                unsigned int other = triangles[t * 3 + k];
+                if (other != collapse.To) {
+                    push(collapse.To, other);
+                    push(other, collapse.To);
+                }
+            }
+        }
+    }
+
+    std::vector<unsigned int> result;
+    result.reserve(live * 3);
+    for (std::size_t t = 0; t < triangle_count; t++) {
+        if (!removed[t]) {
+            result.insert(result.end(), triangles.begin() + t * 3, triangles.begin() + t * 3 + 3);
+        }
+    }
+
+    *error = static_cast<float>(std::sqrt(max_cost));
+    return result;
+}
+
+std::vector<unsigned char> MeshOptimizer::PackVertices(const std::vector<Vertex>& vertices, VertexLayout layout) {
+    std::vector<unsigned char> packed(vertices.size() * Mesh::Stride(layout));
+
+    switch (layout) {
+    case VertexLayout::Full:
+        if (!vertices.empty()) {
+            std::memcpy(packed.data(), vertices.data(), packed.size());
+        }
+        break;
+    case VertexLayout::Compact:
+        for (std::size_t i = 0; i < vertices.size(); i++) {
+            CompactVertex vertex;
+            vertex.Position = vertices[i].Position;
+            vertex.Normal = EncodeNormal(vertices[i].Normal);
+            vertex.TexCoords[0] = HalfFloat(vertices[i].TexCoords.x);
+            vertex.TexCoords[1] = HalfFloat(vertices[i].TexCoords.y);
+            std::memcpy(packed.data() + i * sizeof(CompactVertex), &vertex, sizeof(CompactVertex));
+        }
+        break;
+    }
+
+    return packed;
+}
+
+std::vector<unsigned char> MeshOptimizer::PackIndices(const std::vector<unsigned int>& indices, std::size_t vertex_count, GLenum* type) {
+    if (vertex_count > std::numeric_limits<std::uint16_t>::max() + 1u) {
+        *type = GL_UNSIGNED_INT;
+        std::vector<unsigned char> packed(indices.size() * sizeof(std::uint32_t));
+        if (!indices.empty()) {
+            std::memcpy(packed.data(), indices.data(), packed.size());
+        }
+        return packed;
+    }
+
+    *type = GL_UNSIGNED_SHORT;
+    std::vector<unsigned char> packed(indices.size() * sizeof(std::uint16_t));
+    for (std::size_t i = 0; i < indices.size(); i++) {
+        std::uint16_t index = static_cast<std::uint16_t>(indices[i]);
+        std::memcpy(packed.data() + i * sizeof(std::uint16_t), &index, sizeof(std::uint16_t));
+    }
+    return packed;
+}
+
+std::uint32_t MeshOptimizer::EncodeNormal(const glm::vec3& normal) {
+    float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    glm::vec3 n = length > 0.0f ? normal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+
+    // Lower hemisphere folds over the diagonals of the octahedron
+    glm::vec2 encoded(n.x, n.y);
+    if (n.z < 0.0f) {
+        encoded.x = (1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+        encoded.y = (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+    }
+
+    std::int32_t x = static_cast<std::int32_t>(std::round(std::clamp(encoded.x, -1.0f, 1.0f) * 511.0f));
+    std::int32_t y = static_cast<std::int32_t>(std::round(std::clamp(encoded.y, -1.0f, 1.0f) * 511.0f));
+    return (static_cast<std::uint32_t>(x) & 0x3FF) | ((static_cast<std::uint32_t>(y) & 0x3FF) << 10);
+}
+
+std::uint16_t MeshOptimizer::HalfFloat(float value) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    std::uint32_t sign = (bits >> 16) & 0x8000;
+    std::uint32_t biased = (bits >> 23) & 0xFF;
+    std::uint32_t mantissa = bits & 0x7FFFFF;
+
+    // Infinity and NaN
+    if (biased == 0xFF) {
+        return static_cast<std::uint16_t>(sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0));
+    }
+
+    std::int32_t exponent = static_cast<std::int32_t>(biased) - 127 + 15;
+    if (exponent >= 31) {
+        return static_cast<std::uint16_t>(sign | 0x7C00);
+    }
+
+    // Subnormal half, values too small for it become zero
+    if (exponent <= 0) {
+        if (exponent < -10) {
+            return static_cast<std::uint16_t>(sign);
+        }
+        mantissa |= 0x800000;
+        std::uint32_t shift = static_cast<std::uint32_t>(14 - exponent);
+        std::uint32_t half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1) {
+            half++;
+        }
+        return static_cast<std::uint16_t>(sign | half);
+    }
+
+    // Rounding carry may overflow into exponent, which still gives the nearest value
+    std::uint32_t half = (static_cast<std::uint32_t>(exponent) << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000) {
+        half++;
+    }
+    return static_cast<std::uint16_t>(sign | half);
+}
+
+float MeshOptimizer::VertexScore(int cache_position, unsigned int remaining) {
+    if (remaining == 0) {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if (cache_position >= 0) {
+        // Vertices of the last triangle get fixed score, so the same triangle fan is not always preferred
+        if (cache_position < 3) {
+            score = LAST_TRIANGLE_SCORE;
+        } else {
+            float scale = 1.0f / static_cast<float>(CACHE_SIZE - 3);
+            score = std::pow(1.0f - static_cast<float>(cache_position - 3) * scale, CACHE_DECAY_POWER);
+        }
+    }
+
+    // Vertices with few triangles left are finished first
+    score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining), -VALENCE_BOOST_POWER);
+    return score;
+}
+
+MeshOptimizer::Quadric::Quadric(const glm::vec3& normal, float distance, float weight) {
+    double a = normal.x, b = normal.y, c = normal.z, d = distance;
+    A2 = a * a * weight; AB = a * b * weight; AC = a * c * weight; AD = a * d * weight;
+    B2 = b * b * weight; BC = b * c * weight; BD = b * d * weight;
+    C2 = c * c * weight; CD = c * d * weight;
+    D2 = d * d * weight;
+    Weight = weight;
+}
+
+MeshOptimizer::Quadric& MeshOptimizer::Quadric::operator+=(const Quadric& other) {
+    A2 += other.A2; AB += other.AB; AC += other.AC; AD += other.AD;
+    B2 += other.B2; BC += other.BC; BD += other.BD;
+    C2 += other.C2; CD += other.CD;
+    D2 += other.D2;
+    Weight += other.Weight;
+
+    return *this;
+}
+
+double MeshOptimizer::Quadric::Evaluate(const glm::vec3& point) const {
+    if (Weight <= 0.0) {
+        return 0.0;
+    }
+
+    double x = point.x, y = point.y, z = point.z;
+    double sum = A2 * x * x + 2 * AB * x * y + 2 * AC * x * z + 2 * AD * x
+               + B2 * y * y + 2 * BC * y * z + 2 * BD * y
+               + C2 * z * z + 2 * CD * z
+               + D2;
+    return std::max(sum, 0.0) / Weight;
+}
@@ -0,0 +1,83 @@
+#ifndef MeshOptimizer_h
+#define MeshOptimizer_h
+
+#include "Mesh.h"
+
+#pragma warning(push, 0)
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#pragma warning(pop)
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Mesh optimizer
+ *
+ * Prepares imported triangle lists for drawing. Triangles are reordered
+ * for post-transform vertex cache (Forsyth's linear-speed optimization),
+ * then vertices are renumbered in order of first use so fetches walk the
+ * vertex buffer forwards. Packing turns the result into upload-ready
+ * bytes in the requested layout with 16-bit indices where they suffice.
+ * Simplification collapses edges in order of quadric error and only
+ * rewrites indices, so every level of detail shares one vertex buffer.
+ */
+class MeshOptimizer {
+public:
+    static void OptimizeVertexCache(std::vector<unsigned int>* indices, std::size_t vertex_count);
+    // Also drops vertices no triangle refers to
+    static void OptimizeVertexFetch(std::vector<Vertex>* vertices, std::vector<unsigned int>* indices);
+
+    // Collapses edges until at most target indices remain or nothing can be collapsed. Open
+    // borders, UV and normal seams included, are kept in place. Error receives the largest
+    // deviation introduced, in model units
+    static std::vector<unsigned int> Simplify(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                                              std::size_t target_index_count, float* error);
+
+    static std::vector<unsigned char> PackVertices(const std::vector<Vertex>& vertices, VertexLayout layout);
+    // Type is GL_UNSIGNED_SHORT if every vertex fits, GL_UNSIGNED_INT otherwise
+    static std::vector<unsigned char> PackIndices(const std::vector<unsigned int>& indices, std::size_t vertex_count, GLenum* type);
+
+    static std::uint32_t EncodeNormal(const glm::vec3& normal);
+    static std::uint16_t HalfFloat(float value);
+
+private:
+    // Simulated cache is a bit smaller than hardware ones, which keeps the order good on all of them
+    static constexpr std::size_t CACHE_SIZE = 32;
+    static constexpr float CACHE_DECAY_POWER = 1.5f;
+    static constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+    static constexpr float VALENCE_BOOST_SCALE = 2.0f;
+    static constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+    static float VertexScore(int cache_position, unsigned int remaining);
+
+    // Sum of squared distances to planes of triangles, weighted by their area
+    struct Quadric {
+        double A2{ 0 }, AB{ 0 }, AC{ 0 }, AD{ 0 };
+        double B2{ 0 }, BC{ 0 }, BD{ 0 };
+        double C2{ 0 }, CD{ 0 };
+        double D2{ 0 };
+        double Weight{ 0 };
+
+        Quadric() = default;
+        Quadric(const glm::vec3& normal, float distance, float weight);
+
+        Quadric& operator+=(const Quadric& other);
+        // Mean squared distance of point to the planes
+        double Evaluate(const glm::vec3& point) const;
+    };
+
+    struct Collapse {
+        double Cost;
+        unsigned int From;
+        unsigned int To;
+        unsigned int FromVersion;
+        unsigned int ToVersion;
+
+        bool operator>(const Collapse& other) const { return Cost > other.Cost; }
+    };
+};
+
+#endif
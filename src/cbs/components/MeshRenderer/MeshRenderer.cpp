@@ -1,10 +1,25 @@
 #include "MeshRenderer.h"
 
-MeshRenderer::MeshRenderer(const std::string& path, ShaderProgram::Type type)
-    : Drawable(type) {
+#include "MeshOptimizer.h"
+#include "../../../rendering/TextureLoader.h"
+
+#include <algorithm>
+
+MeshRenderer::MeshRenderer(const std::string& path, ShaderProgram::Type type, VertexLayout layout)
+    : Drawable(type)
+    , m_Layout(layout) {
     LoadModel(path);
 }
 
+MeshRenderer::~MeshRenderer() {
+    // Every texture of every mesh was loaded once
+    for (const Mesh& mesh : m_Meshes) {
+        for (const Texture& texture : mesh.Textures()) {
+            g_TextureLoader.Unload(texture.ID);
+        }
+    }
+}
+
 void MeshRenderer::MakeConnectors(MessageManager& message_manager) {
     message_manager.Make(this, ModelIn);
 }
@@ -18,23 +33,69 @@ void MeshRenderer::Destroy() {
 }
 
 void MeshRenderer::Draw(const ShaderProgram &shader) const {
-    shader.Uniform("model", ModelIn);
-    
     for (const Mesh &mesh: m_Meshes) {
-        mesh.Draw(shader);
+        mesh.Draw(shader, m_Lod);
     }
 }
 
-// duplicated
-void MeshRenderer::NetworkDraw(const ShaderProgram &shader, glm::mat4 local_to_world) const {
-    shader.Uniform("model", ModelIn);
-    
-    for (const Mesh &mesh: m_Meshes) {
-        mesh.Draw(shader);
+unsigned int MeshRenderer::MaterialMaps() const {
+    unsigned int maps = ShaderVariants::NO_MAPS;
+    for (const Mesh& mesh : m_Meshes) {
+        maps |= mesh.Maps();
     }
+
+    return maps;
+}
+
+glm::mat4 MeshRenderer::Model() const {
+    return ModelIn.Connected() ? ModelIn.Value() : glm::mat4(1.0f);
+}
+
+bool MeshRenderer::LocalBounds(AABB* bounds) const {
+    if (m_Bounds.Empty()) {
+        return false;
+    }
+
+    *bounds = m_Bounds;
+    return true;
+}
+
+ThreadPool& MeshRenderer::Importers() {
+    static ThreadPool importers;
+    return importers;
+}
+
+void MeshRenderer::ScreenSize(float fraction) {
+    // Coarsest level within the limit, levels up to the current one get looser limit so it is kept
+    std::size_t lod = 0;
+    for (std::size_t i = m_LodErrors.size(); i-- > 1;) {
+        float limit = MAX_SCREEN_ERROR * (i <= m_Lod ? 1.0f + LOD_HYSTERESIS : 1.0f - LOD_HYSTERESIS);
+        if (m_LodErrors[i] * fraction <= limit) {
+            lod = i;
+            break;
+        }
+    }
+
+    m_Lod = lod;
 }
 
 void MeshRenderer::LoadModel(const std::string& path) {
+    m_Directory = path.substr(0, path.find_last_of('/'));
+
+    std::uint64_t key = MeshCache::Key(path, m_Layout);
+    MappedFile file;
+    std::vector<MeshCache::MeshView> views;
+    if (file.Open(MeshCache::Path(key)) && MeshCache::Parse(file, m_Layout, &views)) {
+        m_Meshes.reserve(views.size());
+        for (const MeshCache::MeshView& view : views) {
+            m_Meshes.emplace_back(view.Vertices, view.VertexCount, m_Layout, view.Indices, view.IndexCount, view.IndexType, view.Lods,
+                                  view.Bounds, LoadTextures(view.Textures));
+            m_Bounds.Merge(view.Bounds);
+        }
+        ComputeLodErrors();
+        return;
+    }
+
     Assimp::Importer importer;
     const aiScene *scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
     
@@ -43,125 +104,151 @@ void MeshRenderer::LoadModel(const std::string& path) {
         return;
     }
     
-    m_Directory = path.substr(0, path.find_last_of('/'));
-    m_Meshes.reserve(scene->mRootNode->mNumMeshes);
-    ProcessNode(scene->mRootNode, scene);
+    std::vector<const aiMesh*> imported;
+    ProcessNode(scene->mRootNode, scene, imported);
+
+    std::vector<MeshCache::MeshData> meshes(imported.size());
+    Importers().ParallelFor(imported.size(), [&](std::size_t begin, std::size_t end, unsigned int) {
+        for (std::size_t i = begin; i < end; i++) {
+            ProcessMesh(imported[i], scene, m_Layout, meshes[i]);
+        }
+    });
+    MeshCache::Store(key, m_Layout, meshes);
+
+    // Uploads stay on GL thread, one after another once everything is converted
+    m_Meshes.reserve(meshes.size());
+    for (const MeshCache::MeshData& data : meshes) {
+        m_Meshes.emplace_back(data.Vertices.data(), data.VertexCount, m_Layout, data.Indices.data(), data.IndexCount, data.IndexType, data.Lods,
+                              data.Bounds, LoadTextures(data.Textures));
+        m_Bounds.Merge(data.Bounds);
+    }
+    ComputeLodErrors();
+}
+
+void MeshRenderer::ComputeLodErrors() {
+    m_LodErrors.assign(1, 0.0f);
+    float radius = m_Bounds.Empty() ? 0.0f : m_Bounds.Sphere().Radius;
+    if (radius <= 0.0f) {
+        return;
+    }
+
+    // Mesh with fewer levels draws its last one at coarser levels of the model
+    std::size_t levels = 0;
+    for (const Mesh& mesh : m_Meshes) {
+        levels = std::max(levels, mesh.Lods().size());
+    }
+    m_LodErrors.assign(levels, 0.0f);
+    for (const Mesh& mesh : m_Meshes) {
+        for (std::size_t i = 0; i < levels; i++) {
+            float error = mesh.Lods()[std::min(i, mesh.Lods().size() - 1)].Error / radius;
+            m_LodErrors[i] = std::max(m_LodErrors[i], error);
+        }
+    }
 }
 
-void MeshRenderer::ProcessNode(aiNode *node, const aiScene *scene) {
+void MeshRenderer::ProcessNode(const aiNode *node, const aiScene *scene, std::vector<const aiMesh*>& meshes) {
     for (unsigned int i = 0; i < node->mNumMeshes; ++i) {
-        aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
-        ProcessMesh(mesh, scene);
+        meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
     }
     
     for (unsigned int i = 0; i < node->mNumChildren; ++i) {
-        ProcessNode(node->mChildren[i], scene);
+        ProcessNode(node->mChildren[i], scene, meshes);
     }
 }
 
-void MeshRenderer::ProcessMesh(aiMesh *mesh, const aiScene *scene) {
+void MeshRenderer::ProcessMesh(const aiMesh *mesh, const aiScene *scene, VertexLayout layout, MeshCache::MeshData& data) {
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
-    std::vector<Texture> textures;
+    std::vector<MeshCache::TextureReference>& textures = data.Textures;
     
+    vertices.resize(mesh->mNumVertices);
     for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
-        Vertex vertex;
-        glm::vec3 vector;
+        Vertex& vertex = vertices[i];
         
-        vector.x = mesh->mVertices[i].x;
-        vector.y = mesh->mVertices[i].y;
-        vector.z = mesh->mVertices[i].z;
-        vertex.Position = vector;
-        
-        vector.x = mesh->mNormals[i].x;
-        vector.y = mesh->mNormals[i].y;
-        vector.z = mesh->mNormals[i].z;
-        vertex.Normal = vector;
+        vertex.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+        vertex.Normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
         
         // Check if mesh contains texture coordinates
         if (mesh->mTextureCoords[0]) {
-            glm::vec2 texCoords;
-            texCoords.x = mesh->mTextureCoords[0][i].x;
-            texCoords.y = mesh->mTextureCoords[0][i].y;
-            
-            vertex.TexCoords = texCoords;
+            vertex.TexCoords = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
         } else {
             vertex.TexCoords = glm::vec2(0.0f, 0.0f);
         }
         
-        vertices.push_back(vertex);
+        data.Bounds.Extend(vertex.Position);
     }
     
+    indices.reserve(static_cast<std::size_t>(mesh->mNumFaces) * 3);
     for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
-        aiFace face = mesh->mFaces[i];
-        for(unsigned int j = 0; j < face.mNumIndices; j++)
-            indices.push_back(face.mIndices[j]);
+        // Points and lines are left as they are by triangulation, they do not belong to triangle list
+        const aiFace& face = mesh->mFaces[i];
+        if (face.mNumIndices == 3) {
+            indices.insert(indices.end(), face.mIndices, face.mIndices + 3);
+        }
+    }
+    
+    MeshOptimizer::OptimizeVertexCache(&indices, vertices.size());
+    MeshOptimizer::OptimizeVertexFetch(&vertices, &indices);
+    
+    // Every level halves triangles of the previous one, its indices follow those of the finer levels
+    data.Lods.push_back({ 0, indices.size(), 0.0f });
+    std::vector<unsigned int> level = indices;
+    for (std::size_t i = 1; i < LOD_LEVELS; i++) {
+        float error = 0.0f;
+        std::vector<unsigned int> simplified = MeshOptimizer::Simplify(vertices, level, level.size() / 6 * 3, &error);
+        // Locked borders can stop simplification early, such level would not pay off
+        if (simplified.empty() || simplified.size() > level.size() * 3 / 4) {
+            break;
+        }
+        
+        MeshOptimizer::OptimizeVertexCache(&simplified, vertices.size());
+        // Errors of the steps add up, deviation from the full level is at most their sum
+        data.Lods.push_back({ indices.size(), simplified.size(), data.Lods.back().Error + error });
+        indices.insert(indices.end(), simplified.begin(), simplified.end());
+        level = std::move(simplified);
     }
     
+    data.VertexCount = vertices.size();
+    data.Vertices = MeshOptimizer::PackVertices(vertices, layout);
+    data.IndexCount = indices.size();
+    data.Indices = MeshOptimizer::PackIndices(indices, vertices.size(), &data.IndexType);
+    
     // Does mesh contains material
     if (mesh->mMaterialIndex >= 0) {
-        aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
+        const aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
         
-        std::vector<Texture> diffuseMaps = LoadMaterialTextures(material, aiTextureType_DIFFUSE, "diffuse");
+        std::vector<MeshCache::TextureReference> diffuseMaps = LoadMaterialTextures(material, aiTextureType_DIFFUSE, "diffuse");
         textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
         
-        std::vector<Texture> specularMaps = LoadMaterialTextures(material, aiTextureType_SPECULAR, "specular");
+        std::vector<MeshCache::TextureReference> specularMaps = LoadMaterialTextures(material, aiTextureType_SPECULAR, "specular");
         textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
     }
-    
-    m_Meshes.emplace_back(vertices, indices, textures);
 }
 
-std::vector<Texture> MeshRenderer::LoadMaterialTextures(aiMaterial *material, aiTextureType type, std::string typeName) {
-    std::vector<Texture> textures;
+std::vector<MeshCache::TextureReference> MeshRenderer::LoadMaterialTextures(const aiMaterial *material, aiTextureType type, std::string typeName) {
+    std::vector<MeshCache::TextureReference> textures;
     
     for (unsigned int i = 0; i < material->GetTextureCount(type); ++i) {
         aiString string;
         material->GetTexture(type, i, &string);
-        
-        Texture texture;
-        texture.ID = TextureFromFile(string.C_Str(), m_Directory);
-        texture.Type = typeName;
-        texture.Path = string.C_Str();
-        textures.push_back(texture);
+        textures.push_back({ typeName, string.C_Str() });
     }
     
     return textures;
 }
 
-unsigned int MeshRenderer::TextureFromFile(const char *path, const std::string &directory) {
-    std::string filename = std::string(path);
-    filename = directory + '/' + filename;
-    
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
+std::vector<Texture> MeshRenderer::LoadTextures(const std::vector<MeshCache::TextureReference>& references) {
+    std::vector<Texture> textures;
+    textures.reserve(references.size());
     
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data) {
-        GLenum format = 0;
-        if (nrComponents == 1) {
-            format = GL_RED;
-        } else if (nrComponents == 3) {
-            format = GL_RGB;
-        } else if (nrComponents == 4) {
-            format = GL_RGBA;
-        }
-        
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-        
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        
-        stbi_image_free(data);
-    } else {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
+    for (const MeshCache::TextureReference& reference : references) {
+        Texture texture;
+        // Texture starts as placeholder, loader decodes and uploads it in background
+        texture.ID = g_TextureLoader.Load(m_Directory + '/' + reference.Path);
+        texture.Type = reference.Type;
+        texture.Path = reference.Path;
+        textures.push_back(texture);
     }
     
-    return textureID;
+    return textures;
 }
@@ -4,11 +4,13 @@
 #pragma warning(disable: 26495)
 
 #include "Mesh.h"
+#include "MeshCache.h"
 #include "../Component.h"
 #include "../../Object.h"
 #include "../../message_system/PropertyIn.h"
 #include "../../../scenes/Scene.h"
 #include "../../../rendering/Drawable.h"
+#include "../../../utilities/ThreadPool.h"
 
 #pragma warning(push, 0)
 #include <glad/glad.h>
@@ -16,8 +18,6 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include <stb_image.h>
-
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
@@ -27,35 +27,67 @@
 #include <string>
 #include <vector>
 
+/**
+ * Mesh renderer
+ *
+ * Draws model loaded from file. Every mesh carries up to LOD_LEVELS levels
+ * of detail generated at import, level is picked each frame from projected
+ * size of the model so that simplification error stays below
+ * MAX_SCREEN_ERROR of viewport height. Switching needs the size to cross
+ * the limit by LOD_HYSTERESIS, so model near the limit does not flicker.
+ */
 class MeshRenderer : public Component, public Drawable {
 public:
-    MeshRenderer(const std::string& path, ShaderProgram::Type type);
+    static constexpr std::size_t LOD_LEVELS = 4;
+    static constexpr float MAX_SCREEN_ERROR = 0.001f;
+    static constexpr float LOD_HYSTERESIS = 0.25f;
+
+    // Compact layout packs normals and stores texture coordinates as half floats, models opt in when that is enough
+    MeshRenderer(const std::string& path, ShaderProgram::Type type, VertexLayout layout = VertexLayout::Full);
+    ~MeshRenderer() override;
 
     void MakeConnectors(MessageManager& message_manager) override;
     void Initialize() override;
     void Destroy() override;
 
     void Draw(const ShaderProgram &shader) const override;
-    void NetworkDraw(const ShaderProgram &shader, glm::mat4 local_to_world) const override;
+    glm::mat4 Model() const override;
+    bool LocalBounds(AABB* bounds) const override;
+    void ScreenSize(float fraction) override;
+    // Maps of any mesh, meshes lacking one of them keep sampling whatever is bound
+    unsigned int MaterialMaps() const override;
 
     const std::vector<Mesh>& Meshes() const { return m_Meshes; }
 
-    const std::vector<Texture>& TexturesLoaded() const { return m_TexturesLoaded; }
-
     const std::string& Directory() const { return m_Directory; }
 
+    VertexLayout Layout() const { return m_Layout; }
+
+    std::size_t Lod() const { return m_Lod; }
+
     PropertyIn<glm::mat4> ModelIn;
 
 private:
     std::vector<Mesh> m_Meshes;
-    std::vector<Texture> m_TexturesLoaded;
+    AABB m_Bounds;
     std::string m_Directory;
+    VertexLayout m_Layout;
+    // Largest error of each level over all meshes, relative to radius of bounds
+    std::vector<float> m_LodErrors;
+    std::size_t m_Lod{ 0 };
+
+    // Workers converting imported meshes, shared by all renderers
+    static ThreadPool& Importers();
 
+    // Maps cached model if there is one, imports it with Assimp and caches it otherwise
     void LoadModel(const std::string& path);
-    void ProcessNode(aiNode *node, const aiScene *scene);
-    void ProcessMesh(aiMesh *mesh, const aiScene *scene);
-    std::vector<Texture> LoadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName);
-    unsigned int TextureFromFile(const char *path, const std::string &directory);
+    void ComputeLodErrors();
+    // Following only read the scene, so meshes are converted in parallel
+    static void ProcessNode(const aiNode *node, const aiScene *scene, std::vector<const aiMesh*>& meshes);
+    // Converts, optimizes, simplifies and packs single mesh
+    static void ProcessMesh(const aiMesh *mesh, const aiScene *scene, VertexLayout layout, MeshCache::MeshData& data);
+    static std::vector<MeshCache::TextureReference> LoadMaterialTextures(const aiMaterial *mat, aiTextureType type, std::string typeName);
+    std::vector<Texture> LoadTextures(const std::vector<MeshCache::TextureReference>& references);
 };
 
 #pragma warning(default: 26495)
@@ -1,7 +1,5 @@
 #include "PointLight.h"
 
-int PointLight::QUANTITY = 0;
-
 PointLight::PointLight(glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular, float constant, float linear, float quadratic)
     : m_Ambient(ambient)
     , m_Diffuse(diffuse)
@@ -13,9 +11,6 @@ PointLight::PointLight(glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular,
     m_Constant = m_Constant <= 0 ? 0.0000001f : m_Constant;
     m_Linear = m_Linear <= 0 ? 0.0000001f : m_Linear;
     m_Quadratic = m_Quadratic <= 0 ? 0.0000001f : m_Quadratic;
-    m_Index = QUANTITY;
-    
-    QUANTITY = (QUANTITY + 1) % 4;
 }
 
 void PointLight::Initialize() {
@@ -26,15 +21,8 @@ void PointLight::Destroy() {
     Object().Scene().UnregisterLightSource(this);
 }
 
-void PointLight::SetLightProperties(const ShaderProgram& shader) {
-    std::string pointLight = "pointLights[" + std::to_string(m_Index) + "].";
-
-    shader.Uniform(pointLight + "position", Object().Root().Position());
-    shader.Uniform(pointLight + "ambient", m_Ambient);
-    shader.Uniform(pointLight + "diffuse", m_Diffuse);
-    shader.Uniform(pointLight + "constant", m_Constant);
-    shader.Uniform(pointLight + "linear", m_Linear);
-    shader.Uniform(pointLight + "quadratic", m_Quadratic);
+void PointLight::AddToClusters(LightClusters& clusters) const {
+    clusters.Add({ Object().Root().Position(), m_Ambient, m_Diffuse, m_Specular, m_Constant, m_Linear, m_Quadratic });
 }
 
 void PointLight::Ambient(const glm::vec3& ambient) {
@@ -53,6 +41,14 @@ void PointLight::Diffuse(const glm::vec3& diffuse) {
     NumberInRange(m_Diffuse.z);
 }
 
+void PointLight::Specular(const glm::vec3& specular) {
+    m_Specular = specular;
+
+    NumberInRange(m_Specular.x);
+    NumberInRange(m_Specular.y);
+    NumberInRange(m_Specular.z);
+}
+
 void PointLight::Constant(float constant) {
     if (constant <= 0) {
         constant = 0.0000001f;
@@ -17,7 +17,8 @@ public:
     void Initialize() override;
     void Destroy() override;
     
-    void SetLightProperties(const ShaderProgram& shader) override;
+    Kind LightKind() const override { return Kind::POINT; }
+    void AddToClusters(LightClusters& clusters) const override;
     
     const glm::vec3& Ambient() const { return m_Ambient; }
     void Ambient(const glm::vec3& ambient);
@@ -25,6 +26,9 @@ public:
     const glm::vec3& Diffuse() const { return m_Diffuse; }
     void Diffuse(const glm::vec3& diffuse);
     
+    const glm::vec3& Specular() const { return m_Specular; }
+    void Specular(const glm::vec3& specular);
+    
     const float& Constant() const { return m_Constant; }
     void Constant(float constant);
     
@@ -35,13 +39,10 @@ public:
     void Quadratic(float quadratic);
     
 private:
-    static int QUANTITY;
-    
     glm::vec3 m_Ambient;
     glm::vec3 m_Diffuse;
     glm::vec3 m_Specular;
     
-    int m_Index;
     float m_Constant;
     float m_Linear;
     float m_Quadratic;
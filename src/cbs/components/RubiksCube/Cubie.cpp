@@ -1,5 +1,7 @@
 #include "Cubie.h"
 
+#include "../../../rendering/GLState.h"
+
 Cubie::Cubie(const glm::mat4* parent, glm::vec3 position, EColor front, EColor left, EColor right, EColor top, EColor bottom)
     : Drawable(ShaderProgram::Type::PURE_COLOR)
     , m_FrontFace(front)
@@ -14,30 +16,22 @@ Cubie::Cubie(const glm::mat4* parent, glm::vec3 position, EColor front, EColor l
     SetupCubie(ColorToVec(front), ColorToVec(left), ColorToVec(right), ColorToVec(top), ColorToVec(bottom));
 }
 
-Cubie::~Cubie() {
-    glDeleteVertexArrays(1, &m_VAO);
-    glDeleteBuffers(1, &m_VAO);
-}
-
 // TODO: The camera is bound before this occurs inside DrawingManager.
 // Drawing data required is: camera matrix and model matrix for each Cubie.
 void Cubie::Draw(const ShaderProgram& shader) const {
-    glm::mat4 model = glm::translate(*m_ParentModel, m_Position);
-    model = model * glm::toMat4(m_Rotation);
-
-    shader.Uniform("model", model);
-
-    glBindVertexArray(m_VAO);
+    g_GLState.BindVertexArray(m_VAO.ID());
     glDrawArrays(GL_TRIANGLES, 0, 396);
-    glBindVertexArray(0);
 }
 
-void Cubie::NetworkDraw(const ShaderProgram& shader, glm::mat4 local_to_world) const {
-    shader.Uniform("model", local_to_world);
+glm::mat4 Cubie::Model() const {
+    glm::mat4 model = glm::translate(*m_ParentModel, m_Position);
+    return model * glm::toMat4(m_Rotation);
+}
 
-    glBindVertexArray(m_VAO);
-    glDrawArrays(GL_TRIANGLES, 0, 396);
-    glBindVertexArray(0);
+bool Cubie::LocalBounds(AABB* bounds) const {
+    // Stickers stick out slightly of the unit cube
+    *bounds = AABB(glm::vec3(-0.501f), glm::vec3(0.501f));
+    return true;
 }
 
 void Cubie::RotateAround(float angle, glm::vec3 axis) {
@@ -151,13 +145,14 @@ void Cubie::SetupCubie(glm::vec3 front, glm::vec3 left, glm::vec3 right, glm::ve
         -0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  0.0f
     };
 
-    glGenVertexArrays(1, &m_VAO);
-    glGenBuffers(1, &m_VBO);
+    m_VAO = VertexArrayHandle::Create(GLResources::Owner::CUBIES);
+    m_VBO = BufferHandle::Create(GLResources::Owner::CUBIES);
 
-    glBindVertexArray(m_VAO);
+    g_GLState.BindVertexArray(m_VAO.ID());
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO.ID());
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    m_VBO.Bytes(sizeof(vertices));
 
     // Position attribute
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (void*)0);
@@ -167,6 +162,6 @@ void Cubie::SetupCubie(glm::vec3 front, glm::vec3 left, glm::vec3 right, glm::ve
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
     glEnableVertexAttribArray(1);
 
-    glBindVertexArray(0);
+    g_GLState.BindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define Cubie_h
 
 #include "../../../rendering/Drawable.h"
+#include "../../../rendering/GLResources.h"
 
 #define GLM_ENABLE_EXPERIMENTAL
 #pragma warning(push, 0)
@@ -24,10 +25,11 @@ public:
     };
 
     Cubie(const glm::mat4* parent, glm::vec3 position, EColor front, EColor left = BLACK, EColor right = BLACK, EColor top = BLACK, EColor bottom = BLACK);
-    ~Cubie();
 
     void Draw(const ShaderProgram& shader) const override;
-    void NetworkDraw(const ShaderProgram &shader, glm::mat4 local_to_world) const override;
+    glm::mat4 Model() const override;
+    glm::mat4 NetworkModel(const glm::mat4& local_to_world) const override { return local_to_world; }
+    bool LocalBounds(AABB* bounds) const override;
 
     void RotateAround(float angle, glm::vec3 axis);
     void RotationAround(float angle, glm::vec3 axis);
@@ -48,8 +50,8 @@ private:
     glm::quat m_Rotation;
     glm::mat4 m_Model;
 
-    GLuint m_VAO;
-    GLuint m_VBO;
+    VertexArrayHandle m_VAO;
+    BufferHandle m_VBO;
 };
 
 #endif
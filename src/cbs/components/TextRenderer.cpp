@@ -1,14 +1,23 @@
 #include "TextRenderer.h"
 
+#include "../../rendering/FontManager.h"
+#include "../../rendering/GLState.h"
+
+#pragma warning(push, 0)
+#include <glm/gtc/matrix_transform.hpp>
+#pragma warning(pop)
+
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 TextRenderer::TextRenderer(const std::string& font_path, float size)
     : m_Horizontal(EAlign::NONE)
     , m_Vertical(EAlign::NONE)
     , m_Offset(0.0f)
-    , m_Color(0.0f, 0.0f, 0.0f, 1.0f) {
-
-    ImGuiIO& io = ImGui::GetIO();
-    m_Font = io.Fonts->AddFontFromFileTTF(font_path.c_str(), size);
-    io.Fonts->Build();
+    , m_Color(0.0f, 0.0f, 0.0f, 1.0f)
+    , m_Font(g_FontManager.Font(font_path, size)) {
 }
 
 void TextRenderer::MakeConnectors(MessageManager& message_manager) {
@@ -64,14 +73,119 @@ void TextRenderer::NetworkDraw(std::string text) const {
     ImGui::End();
 }
 
+void TextRenderer::DrawRetained(const ShaderProgram& shader) const {
+    if (m_LayoutDirty || m_LayoutWidth != g_Window.Width() || m_LayoutHeight != g_Window.Height()
+        || m_LayoutGeneration != g_FontManager.Generation()) {
+        Layout();
+    }
+    if (m_VertexCount == 0) {
+        return;
+    }
+
+    // Atlas texture is created by Dear ImGui backend
+    GLuint atlas = static_cast<GLuint>(reinterpret_cast<std::intptr_t>(m_Font->ContainerAtlas->TexID));
+
+    shader.Uniform("projection", glm::ortho(0.0f, static_cast<float>(g_Window.Width()), static_cast<float>(g_Window.Height()), 0.0f));
+    shader.Uniform("color", m_Color);
+    shader.Uniform("atlas", 0);
+
+    g_GLState.BindTexture(0, GL_TEXTURE_2D, atlas);
+    g_GLState.BindVertexArray(m_VAO.ID());
+    glDrawArrays(GL_TRIANGLES, 0, m_VertexCount);
+}
+
+void TextRenderer::Layout() const {
+    m_LayoutDirty = false;
+    m_LayoutWidth = g_Window.Width();
+    m_LayoutHeight = g_Window.Height();
+    m_LayoutGeneration = g_FontManager.Generation();
+
+    const float font_size = m_Font->FontSize;
+    const glm::vec2 text_size = m_Font->CalcTextSizeA(font_size, FLT_MAX, 0.0f, m_Text.c_str());
+
+    // Same alignment as the window of Draw(), without window padding
+    glm::vec2 origin(m_Offset.x * m_LayoutWidth, m_Offset.y * m_LayoutHeight);
+    IWidget::Align(&origin.x, 0.0f, m_LayoutWidth - text_size.x, m_Horizontal);
+    IWidget::Align(&origin.y, 0.0f, m_LayoutHeight - text_size.y, m_Vertical);
+    origin = glm::floor(origin);
+
+    // Bytes are taken as code points, text of the scene is ASCII
+    std::vector<TextVertex> vertices;
+    vertices.reserve(m_Text.size() * 6);
+    glm::vec2 pen = origin;
+    for (unsigned char c : m_Text) {
+        if (c == '\n') {
+            pen.x = origin.x;
+            pen.y += font_size;
+            continue;
+        }
+
+        const ImFontGlyph* glyph = m_Font->FindGlyph(static_cast<ImWchar>(c));
+        if (glyph == nullptr) {
+            continue;
+        }
+
+        if (glyph->Visible) {
+            const TextVertex top_left{ pen + glm::vec2(glyph->X0, glyph->Y0), glm::vec2(glyph->U0, glyph->V0) };
+            const TextVertex top_right{ pen + glm::vec2(glyph->X1, glyph->Y0), glm::vec2(glyph->U1, glyph->V0) };
+            const TextVertex bottom_left{ pen + glm::vec2(glyph->X0, glyph->Y1), glm::vec2(glyph->U0, glyph->V1) };
+            const TextVertex bottom_right{ pen + glm::vec2(glyph->X1, glyph->Y1), glm::vec2(glyph->U1, glyph->V1) };
+            vertices.insert(vertices.end(), { top_left, bottom_left, bottom_right, top_left, bottom_right, top_right });
+        }
+        pen.x += glyph->AdvanceX;
+    }
+    m_VertexCount = static_cast<GLsizei>(vertices.size());
+
+    if (!m_VAO) {
+        m_VAO = VertexArrayHandle::Create(GLResources::Owner::FONTS);
+        m_VBO = BufferHandle::Create(GLResources::Owner::FONTS);
+
+        g_GLState.BindVertexArray(m_VAO.ID());
+        glBindBuffer(GL_ARRAY_BUFFER, m_VBO.ID());
+
+        // Position
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, Position));
+        // Texture coords
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, TexCoords));
+    } else {
+        glBindBuffer(GL_ARRAY_BUFFER, m_VBO.ID());
+    }
+
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(TextVertex), vertices.data(), GL_STATIC_DRAW);
+    m_VBO.Bytes(vertices.size() * sizeof(TextVertex));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void TextRenderer::Text(std::string text) {
+    if (text != m_Text) {
+        m_Text = text;
+        m_LayoutDirty = true;
+        MarkChanged();
+    }
+}
+
+void TextRenderer::Color(glm::vec4 color) {
+    if (color != m_Color) {
+        m_Color = color;
+        MarkChanged();
+    }
+}
+
 void TextRenderer::Font(const std::string& path, float size) {
-    ImGuiIO& io = ImGui::GetIO();
-    m_Font = io.Fonts->AddFontFromFileTTF(path.c_str(), size);
-    io.Fonts->Build();
+    // Atlas is rebuilt before next frame if this font is new
+    m_Font = g_FontManager.Font(path, size);
+
+    m_LayoutDirty = true;
+    MarkChanged();
 }
 
 void TextRenderer::Position(glm::vec2 offset, EAlign horizontal, EAlign vertical) {
     m_Offset = offset;
     m_Vertical = vertical;
     m_Horizontal = horizontal;
+
+    m_LayoutDirty = true;
+    MarkChanged();
 }
@@ -3,12 +3,26 @@
 
 #include "Component.h"
 #include "../../rendering/IWidget.h"
+#include "../../rendering/GLResources.h"
 #include "../Object.h"
 #include "../../scenes/Scene.h"
 #include "../message_system/MessageIn.h"
 
+#pragma warning(push, 0)
+#include <glad/glad.h>
+#pragma warning(pop)
+
+#include <cstdint>
 #include <string>
 
+/**
+ * Text renderer
+ *
+ * Retained widget, glyph quads are laid out into its own vertex buffer only
+ * when text, font, position or window size changes, or font atlas is baked
+ * again. Every frame the buffer is drawn by single call, without Dear ImGui
+ * window. Color is a uniform, so changing it does not need new layout.
+ */
 class TextRenderer : public Component, public IWidget {
 public:
     TextRenderer(const std::string& font_path, float size);
@@ -20,14 +34,17 @@ public:
     void Draw() const override;
     void NetworkDraw(std::string text) const override;
 
+    bool Retained() const override { return true; }
+    void DrawRetained(const ShaderProgram& shader) const override;
+
     void Font(const std::string& path, float size);
     void Position(glm::vec2 offset, EAlign horizontal, EAlign vertical);
 
     const std::string Text() const { return m_Text; }
-    void Text(std::string text) { m_Text = text; }
+    void Text(std::string text);
 
     const glm::vec4 Color() const { return m_Color; }
-    void Color(glm::vec4 color) { m_Color = color; }
+    void Color(glm::vec4 color);
 
 public:
     MessageIn<std::string, TextRenderer, &TextRenderer::Text> TextIn;
@@ -41,6 +58,22 @@ private:
     glm::vec2 m_Offset;
     glm::vec4 m_Color;
     ImFont* m_Font;
+
+    // Cached layout, rebuilt lazily by DrawRetained
+    struct TextVertex {
+        glm::vec2 Position;
+        glm::vec2 TexCoords;
+    };
+
+    void Layout() const;
+
+    mutable VertexArrayHandle m_VAO;
+    mutable BufferHandle m_VBO;
+    mutable GLsizei m_VertexCount{ 0 };
+    mutable bool m_LayoutDirty{ true };
+    mutable unsigned int m_LayoutWidth{ 0 };
+    mutable unsigned int m_LayoutHeight{ 0 };
+    mutable std::uint64_t m_LayoutGeneration{ 0 };
 };
 
 #endif
\ No newline at end of file
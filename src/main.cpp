@@ -1,6 +1,12 @@
 #include "utilities/Time.h"
 #include "utilities/Input.h"
 #include "utilities/Window.h"
+#include "rendering/GLState.h"
+#include "rendering/GLResources.h"
+#include "rendering/DebugDraw.h"
+#include "rendering/FontManager.h"
+#include "rendering/GLExtensions.h"
+#include "rendering/TextureLoader.h"
 #include "scenes/MainScene.h"
 
 #pragma warning(push, 0)
@@ -9,26 +15,138 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
 
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <vector>
 #pragma warning(pop)
 
 // Global objects
 Time g_Time;
 Input g_Input;
 Window g_Window;
+GLState g_GLState;
+GLResources g_GLResources;
+GLExtensions g_GLExtensions;
+TextureLoader g_TextureLoader;
+FontManager g_FontManager;
+DebugDraw g_DebugDraw;
+
+// Whole text has to be a decimal number that fits
+static bool ParseNumber(const std::string& text, unsigned int* value) {
+    const char* end = text.data() + text.size();
+    std::from_chars_result result = std::from_chars(text.data(), end, *value);
+    return !text.empty() && result.ec == std::errc() && result.ptr == end;
+}
+
+// Largest difference of any channel between two images, -1 if either fails to load or sizes differ
+static int ImageDifference(const std::string& path, const std::string& reference_path) {
+    int width = 0, height = 0, reference_width = 0, reference_height = 0, channels = 0;
+    unsigned char* image = stbi_load(path.c_str(), &width, &height, &channels, 4);
+    unsigned char* reference = stbi_load(reference_path.c_str(), &reference_width, &reference_height, &channels, 4);
+
+    int difference = -1;
+    if (image != nullptr && reference != nullptr && width == reference_width && height == reference_height) {
+        difference = 0;
+        std::size_t size = static_cast<std::size_t>(width) * height * 4;
+        for (std::size_t i = 0; i < size; i++) {
+            difference = std::max(difference, std::abs(static_cast<int>(image[i]) - static_cast<int>(reference[i])));
+        }
+    }
+
+    stbi_image_free(image);
+    stbi_image_free(reference);
+    return difference;
+}
+
+int main(int argc, char* argv[]) {
+    // Command line
+    // --headless              render offscreen without window and server
+    // --frames <count>        number of frames drawn in headless mode
+    // --dump <frame>          save given frame as PNG, can be repeated
+    // --dump-prefix <path>    path prefix of saved frames
+    // --bake                  write meshes, textures and font atlas of the scene into caches and exit
+    // --record <path>         record every drawn frame, into Y4M stream if path ends with .y4m, numbered PNG files otherwise
+    // --dynamic-resolution    scale the scene down to hold 60 fps on weak GPUs, ignored in headless mode
+    // --compare <path>        compare dumped frames with PNG files of given path prefix, exit with failure on mismatch
+    // --tolerance <value>     largest difference of any channel that still matches, 0 to 255
+    // --stats                 print rendering statistics on exit, always on in headless mode
+    bool headless = false;
+    bool bake = false;
+    bool dynamic_resolution = false;
+    bool stats = false;
+    unsigned int frames = 300;
+    std::vector<unsigned int> dumped_frames;
+    std::string dump_prefix = "frame_";
+    std::string record_path;
+    std::string reference_prefix;
+    unsigned int tolerance = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--headless") {
+            headless = true;
+        } else if ((arg == "--frames" || arg == "--dump" || arg == "--tolerance") && i + 1 < argc) {
+            unsigned int value = 0;
+            if (!ParseNumber(argv[++i], &value)) {
+                std::cout << "Invalid value of " << arg << ": " << argv[i] << '\n';
+                return EXIT_FAILURE;
+            }
+
+            if (arg == "--frames") {
+                frames = value;
+            } else if (arg == "--dump") {
+                dumped_frames.push_back(value);
+            } else {
+                tolerance = value;
+            }
+        } else if (arg == "--compare" && i + 1 < argc) {
+            reference_prefix = argv[++i];
+        } else if (arg == "--dump-prefix" && i + 1 < argc) {
+            dump_prefix = argv[++i];
+        } else if (arg == "--record" && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (arg == "--dynamic-resolution") {
+            dynamic_resolution = true;
+        } else if (arg == "--stats") {
+            stats = true;
+        } else if (arg == "--bake") {
+            bake = true;
+        } else {
+            std::cout << "Unknown argument: " << arg << '\n';
+        }
+    }
+
+    // Null platform needs no display, context comes from EGL without surface or OSMesa
+    if (headless) {
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    }
 
-int main() {
     // Initialize OpenGL
-    glfwInit();
+    if (!glfwInit()) {
+        std::cout << "Failed to initialize GLFW\n";
+        return EXIT_FAILURE;
+    }
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    if (headless) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+    }
     
     // Create window
     g_Window.Initialize(1920, 1080, "Rubik's cube");
+    if (!g_Window && headless) {
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+        g_Window.Initialize(1920, 1080, "Rubik's cube");
+    }
     if (!g_Window) {
         glfwTerminate();
         std::cout << "Failed to create GLFW window\n";
@@ -41,22 +159,60 @@ int main() {
         std::cout << "Failed to initialize GLAD\n";
         return EXIT_FAILURE;
     }
+    g_GLExtensions.Load();
+    g_TextureLoader.Initialize();
     
     // Set callbacks
     glfwSetFramebufferSizeCallback(g_Window, framebuffer_size_callback);
     glfwSetCursorPosCallback(g_Window, mouse_callback);
     glfwSetScrollCallback(g_Window, scroll_callback);
     
-    // Main scene
-    MainScene main_scene;
-    main_scene.PreRun();
-    main_scene.CreateScene();
-    // calling run starts the game loop
-    main_scene.Run();
-    main_scene.PostRun();
+    bool mismatched = false;
+    // Main scene lives in a block, its GL objects are released before context is destroyed
+    {
+        MainScene main_scene;
+        main_scene.PreRun();
+        main_scene.CreateScene();
+        // Fonts of all widgets are known now, atlas is rasterized once
+        g_FontManager.Bake();
+        if (!record_path.empty()) {
+            main_scene.Record(record_path);
+        }
+        // Headless output has to stay deterministic, scaled frames depend on timing
+        if (dynamic_resolution && !headless) {
+            main_scene.ResolutionScaling(0.5f, 1.0f, 60.0f);
+        }
+        main_scene.PrintStatistics(stats || headless);
+        // calling run starts the game loop
+        if (bake) {
+            // Meshes and font atlas were cached while creating scene, textures are written once uploaded
+            g_TextureLoader.Finish();
+        } else if (headless) {
+            main_scene.RunHeadless(frames, dumped_frames, dump_prefix);
+
+            // Dumped frames are written already, each one is checked against its reference
+            if (!reference_prefix.empty()) {
+                for (unsigned int frame : dumped_frames) {
+                    std::string reference_path = reference_prefix + std::to_string(frame) + ".png";
+                    int difference = ImageDifference(dump_prefix + std::to_string(frame) + ".png", reference_path);
+                    if (difference < 0 || static_cast<unsigned int>(difference) > tolerance) {
+                        std::cout << "Frame " << frame << " does not match " << reference_path << ", difference " << difference << '\n';
+                        mismatched = true;
+                    }
+                }
+            }
+        } else {
+            main_scene.Run();
+        }
+        main_scene.PostRun();
+    }
+    g_TextureLoader.Destroy();
+    g_DebugDraw.Destroy();
+    // Objects released above are deleted while context is still current
+    g_GLResources.Collect();
     
     // End of application
     glfwSetWindowShouldClose(g_Window, true);
     glfwTerminate();
-    return EXIT_SUCCESS;
+    return mismatched ? EXIT_FAILURE : EXIT_SUCCESS;
 }
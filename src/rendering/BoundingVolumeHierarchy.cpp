@@ -0,0 +1,228 @@
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <assert.h>
+
+BoundingVolumeHierarchy::BoundingVolumeHierarchy(float margin)
+    : m_Root(NULL_NODE)
+    , m_FreeList(NULL_NODE)
+    , m_Margin(margin) {
+}
+
+int BoundingVolumeHierarchy::Insert(const AABB& box, int user_data) {
+    int leaf = AllocateNode();
+    m_Nodes[leaf].Box = Fatten(box);
+    m_Nodes[leaf].UserData = user_data;
+
+    InsertLeaf(leaf);
+
+    return leaf;
+}
+
+void BoundingVolumeHierarchy::Remove(int proxy) {
+    assert(proxy >= 0 && proxy < static_cast<int>(m_Nodes.size()) && m_Nodes[proxy].Leaf());
+
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+}
+
+bool BoundingVolumeHierarchy::Update(int proxy, const AABB& box) {
+    assert(proxy >= 0 && proxy < static_cast<int>(m_Nodes.size()) && m_Nodes[proxy].Leaf());
+
+    if (m_Nodes[proxy].Box.Contains(box)) {
+        return false;
+    }
+
+    RemoveLeaf(proxy);
+    m_Nodes[proxy].Box = Fatten(box);
+    InsertLeaf(proxy);
+
+    return true;
+}
+
+int BoundingVolumeHierarchy::AllocateNode() {
+    if (m_FreeList == NULL_NODE) {
+        m_Nodes.emplace_back();
+        return static_cast<int>(m_Nodes.size()) - 1;
+    }
+
+    int node = m_FreeList;
+    m_FreeList = m_Nodes[node].Parent;
+    m_Nodes[node] = Node();
+
+    return node;
+}
+
+void BoundingVolumeHierarchy::FreeNode(int node) {
+    m_Nodes[node].Parent = m_FreeList;
+    m_Nodes[node].Height = -1;
+    m_FreeList = node;
+}
+
+void BoundingVolumeHierarchy::InsertLeaf(int leaf) {
+    if (m_Root == NULL_NODE) {
+        m_Root = leaf;
+        m_Nodes[leaf].Parent = NULL_NODE;
+        return;
+    }
+
+    // Find the best sibling using surface area heuristic
+    const AABB leaf_box = m_Nodes[leaf].Box;
+    int index = m_Root;
+    while (!m_Nodes[index].Leaf()) {
+        const Node& node = m_Nodes[index];
+
+        float area = node.Box.SurfaceArea();
+        float combined_area = Merged(node.Box, leaf_box).SurfaceArea();
+
+        // Cost of creating new parent for this node and the leaf
+        float cost = 2.0f * combined_area;
+        // Minimum cost of pushing the leaf further down the tree
+        float inheritance_cost = 2.0f * (combined_area - area);
+
+        auto descend_cost = [&](int child) {
+            const AABB& child_box = m_Nodes[child].Box;
+            float merged_area = Merged(child_box, leaf_box).SurfaceArea();
+            if (m_Nodes[child].Leaf()) {
+                return merged_area + inheritance_cost;
+            }
+            return merged_area - child_box.SurfaceArea() + inheritance_cost;
+        };
+
+        float left_cost = descend_cost(node.Left);
+        float right_cost = descend_cost(node.Right);
+        if (cost < left_cost && cost < right_cost) {
+            break;
+        }
+
+        index = left_cost < right_cost ? node.Left : node.Right;
+    }
+
+    // Create new parent for the sibling and the leaf
+    int sibling = index;
+    int old_parent = m_Nodes[sibling].Parent;
+    int new_parent = AllocateNode();
+    m_Nodes[new_parent].Parent = old_parent;
+    m_Nodes[new_parent].Box = Merged(leaf_box, m_Nodes[sibling].Box);
+    m_Nodes[new_parent].Height = m_Nodes[sibling].Height + 1;
+    m_Nodes[new_parent].Left = sibling;
+    m_Nodes[new_parent].Right = leaf;
+    m_Nodes[sibling].Parent = new_parent;
+    m_Nodes[leaf].Parent = new_parent;
+
+    if (old_parent != NULL_NODE) {
+        if (m_Nodes[old_parent].Left == sibling) {
+            m_Nodes[old_parent].Left = new_parent;
+        } else {
+            m_Nodes[old_parent].Right = new_parent;
+        }
+    } else {
+        m_Root = new_parent;
+    }
+
+    Refit(m_Nodes[leaf].Parent);
+}
+
+void BoundingVolumeHierarchy::RemoveLeaf(int leaf) {
+    if (leaf == m_Root) {
+        m_Root = NULL_NODE;
+        return;
+    }
+
+    int parent = m_Nodes[leaf].Parent;
+    int grand_parent = m_Nodes[parent].Parent;
+    int sibling = m_Nodes[parent].Left == leaf ? m_Nodes[parent].Right : m_Nodes[parent].Left;
+
+    // Sibling takes place of the parent
+    m_Nodes[sibling].Parent = grand_parent;
+    FreeNode(parent);
+
+    if (grand_parent != NULL_NODE) {
+        if (m_Nodes[grand_parent].Left == parent) {
+            m_Nodes[grand_parent].Left = sibling;
+        } else {
+            m_Nodes[grand_parent].Right = sibling;
+        }
+
+        Refit(grand_parent);
+    } else {
+        m_Root = sibling;
+    }
+}
+
+void BoundingVolumeHierarchy::Refit(int node) {
+    // Walk to the root, rebalancing and fixing boxes of ancestors
+    while (node != NULL_NODE) {
+        node = Balance(node);
+
+        int left = m_Nodes[node].Left;
+        int right = m_Nodes[node].Right;
+        m_Nodes[node].Height = 1 + std::max(m_Nodes[left].Height, m_Nodes[right].Height);
+        m_Nodes[node].Box = Merged(m_Nodes[left].Box, m_Nodes[right].Box);
+
+        node = m_Nodes[node].Parent;
+    }
+}
+
+int BoundingVolumeHierarchy::Balance(int a) {
+    if (m_Nodes[a].Leaf() || m_Nodes[a].Height < 2) {
+        return a;
+    }
+
+    int b = m_Nodes[a].Left;
+    int c = m_Nodes[a].Right;
+    int balance = m_Nodes[c].Height - m_Nodes[b].Height;
+
+    // Rotates child up to replace node a, a becomes its left child
+    auto rotate_up = [&](int child, int sibling, bool child_was_right) {
+        int f = m_Nodes[child].Left;
+        int g = m_Nodes[child].Right;
+
+        m_Nodes[child].Left = a;
+        m_Nodes[child].Parent = m_Nodes[a].Parent;
+        m_Nodes[a].Parent = child;
+
+        int parent = m_Nodes[child].Parent;
+        if (parent != NULL_NODE) {
+            if (m_Nodes[parent].Left == a) {
+                m_Nodes[parent].Left = child;
+            } else {
+                m_Nodes[parent].Right = child;
+            }
+        } else {
+            m_Root = child;
+        }
+
+        // Taller grandchild stays with child, the other one goes to a
+        int taller = m_Nodes[f].Height > m_Nodes[g].Height ? f : g;
+        int shorter = taller == f ? g : f;
+        m_Nodes[child].Right = taller;
+        if (child_was_right) {
+            m_Nodes[a].Right = shorter;
+        } else {
+            m_Nodes[a].Left = shorter;
+        }
+        m_Nodes[shorter].Parent = a;
+
+        m_Nodes[a].Box = Merged(m_Nodes[sibling].Box, m_Nodes[shorter].Box);
+        m_Nodes[a].Height = 1 + std::max(m_Nodes[sibling].Height, m_Nodes[shorter].Height);
+        m_Nodes[child].Box = Merged(m_Nodes[a].Box, m_Nodes[taller].Box);
+        m_Nodes[child].Height = 1 + std::max(m_Nodes[a].Height, m_Nodes[taller].Height);
+
+        return child;
+    };
+
+    if (balance > 1) {
+        return rotate_up(c, b, true);
+    }
+    if (balance < -1) {
+        return rotate_up(b, c, false);
+    }
+
+    return a;
+}
+
+AABB BoundingVolumeHierarchy::Fatten(const AABB& box) const {
+    glm::vec3 margin(m_Margin);
+    return AABB(box.Min - margin, box.Max + margin);
+}
@@ -0,0 +1,117 @@
+#ifndef BoundingVolumeHierarchy_h
+#define BoundingVolumeHierarchy_h
+
+#include "Bounds.h"
+#include "Frustum.h"
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Dynamic bounding volume hierarchy
+ *
+ * Binary tree of AABBs kept balanced by rotations, leaves are proxies
+ * of objects identified by user data. Leaves store boxes enlarged by
+ * margin, so object moving within its fat box does not touch the tree.
+ * Once it leaves the box, leaf is reinserted and ancestors are refitted.
+ */
+class BoundingVolumeHierarchy {
+public:
+    static constexpr int NULL_NODE = -1;
+    // Stack of balanced tree grows by one per level, deeper trees spill into heap
+    static constexpr std::size_t QUERY_STACK_SIZE = 64;
+
+    explicit BoundingVolumeHierarchy(float margin = 0.1f);
+
+    int Insert(const AABB& box, int user_data);
+    void Remove(int proxy);
+    // Returns true if proxy had to be reinserted
+    bool Update(int proxy, const AABB& box);
+
+    int UserData(int proxy) const { return m_Nodes[proxy].UserData; }
+    void UserData(int proxy, int user_data) { m_Nodes[proxy].UserData = user_data; }
+    const AABB& FatBounds(int proxy) const { return m_Nodes[proxy].Box; }
+    int Height() const { return m_Root != NULL_NODE ? m_Nodes[m_Root].Height : 0; }
+
+    /**
+     * Query
+     *
+     * Calls callback with user data of every leaf intersecting frustum.
+     * Subtrees entirely inside frustum are reported without further tests.
+     */
+    template <class Callback>
+    void Query(const Frustum& frustum, Callback callback) const {
+        if (m_Root == NULL_NODE) {
+            return;
+        }
+
+        // Lowest bit of stack entry marks subtree known to be inside. Stack is local,
+        // so queries from several threads at once are safe
+        std::array<int, QUERY_STACK_SIZE> stack;
+        std::size_t size = 0;
+        std::vector<int> overflow;
+        auto push = [&](int entry) {
+            if (size < stack.size()) {
+                stack[size++] = entry;
+            } else {
+                overflow.push_back(entry);
+            }
+        };
+
+        push(m_Root << 1);
+        while (size > 0) {
+            int entry;
+            if (!overflow.empty()) {
+                entry = overflow.back();
+                overflow.pop_back();
+            } else {
+                entry = stack[--size];
+            }
+
+            const Node& node = m_Nodes[entry >> 1];
+            int inside = entry & 1;
+            if (!inside) {
+                Frustum::EResult result = frustum.Test(node.Box);
+                if (result == Frustum::EResult::OUTSIDE) {
+                    continue;
+                }
+                inside = result == Frustum::EResult::INSIDE;
+            }
+
+            if (node.Leaf()) {
+                callback(node.UserData);
+            } else {
+                push((node.Left << 1) | inside);
+                push((node.Right << 1) | inside);
+            }
+        }
+    }
+
+private:
+    struct Node {
+        AABB Box;
+        int Parent{ NULL_NODE };    // Next free node when in free list
+        int Left{ NULL_NODE };
+        int Right{ NULL_NODE };
+        int Height{ 0 };
+        int UserData{ -1 };
+
+        bool Leaf() const { return Left == NULL_NODE; }
+    };
+
+    int AllocateNode();
+    void FreeNode(int node);
+    void InsertLeaf(int leaf);
+    void RemoveLeaf(int leaf);
+    void Refit(int node);
+    int Balance(int node);
+    AABB Fatten(const AABB& box) const;
+
+    std::vector<Node> m_Nodes;
+    int m_Root;
+    int m_FreeList;
+    float m_Margin;
+};
+
+#endif
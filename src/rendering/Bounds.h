@@ -0,0 +1,75 @@
+#ifndef Bounds_h
+#define Bounds_h
+
+#pragma warning(push, 0)
+#include <glm/glm.hpp>
+#pragma warning(pop)
+
+#include <cfloat>
+
+struct BoundingSphere {
+    glm::vec3 Center{ 0.0f };
+    float Radius{ 0.0f };
+};
+
+// Axis aligned bounding box, default constructed box is empty
+struct AABB {
+    glm::vec3 Min{ FLT_MAX };
+    glm::vec3 Max{ -FLT_MAX };
+
+    AABB() = default;
+    AABB(const glm::vec3& min, const glm::vec3& max)
+        : Min(min)
+        , Max(max) {
+    }
+
+    bool Empty() const { return Min.x > Max.x || Min.y > Max.y || Min.z > Max.z; }
+
+    glm::vec3 Center() const { return (Min + Max) * 0.5f; }
+    glm::vec3 Extents() const { return (Max - Min) * 0.5f; }
+    BoundingSphere Sphere() const { return { Center(), glm::length(Extents()) }; }
+
+    float SurfaceArea() const {
+        glm::vec3 size = Max - Min;
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    void Extend(const glm::vec3& point) {
+        Min = glm::min(Min, point);
+        Max = glm::max(Max, point);
+    }
+
+    void Merge(const AABB& other) {
+        Min = glm::min(Min, other.Min);
+        Max = glm::max(Max, other.Max);
+    }
+
+    bool Contains(const AABB& other) const {
+        return Min.x <= other.Min.x && Min.y <= other.Min.y && Min.z <= other.Min.z
+            && Max.x >= other.Max.x && Max.y >= other.Max.y && Max.z >= other.Max.z;
+    }
+
+    // Box enclosing this box transformed by given matrix
+    AABB Transformed(const glm::mat4& transform) const {
+        if (Empty()) {
+            return *this;
+        }
+
+        glm::vec3 center = glm::vec3(transform * glm::vec4(Center(), 1.0f));
+        glm::vec3 extents = Extents();
+        glm::vec3 world_extents(0.0f);
+        for (int i = 0; i < 3; i++) {
+            world_extents += glm::abs(glm::vec3(transform[i])) * extents[i];
+        }
+
+        return AABB(center - world_extents, center + world_extents);
+    }
+};
+
+inline AABB Merged(const AABB& lhs, const AABB& rhs) {
+    AABB result = lhs;
+    result.Merge(rhs);
+    return result;
+}
+
+#endif
@@ -1,90 +1,29 @@
 #include "Cubemap.h"
 
+#include "GLState.h"
+#include "TextureLoader.h"
+
 Cubemap::Cubemap(const std::string& right, const std::string& left, const std::string& top, const std::string& bottom, const std::string& back, const std::string& front, ShaderProgram::Type type) 
     : Drawable(type) {
     m_Load(right, left, top, bottom, back, front);
     m_Initialize();
 }
 
-void Cubemap::Draw(const ShaderProgram& shader) const {
-    shader.Uniform("skybox", 0);
-    
-    glBindVertexArray(m_VAO);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_ID);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
+Cubemap::~Cubemap() {
+    g_TextureLoader.Unload(m_ID);
 }
 
-// duplicated
-void Cubemap::NetworkDraw(const ShaderProgram& shader, glm::mat4 local_to_world) const {
+void Cubemap::Draw(const ShaderProgram& shader) const {
     shader.Uniform("skybox", 0);
     
-    glBindVertexArray(m_VAO);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_ID);
+    g_GLState.BindVertexArray(m_VAO.ID());
+    g_GLState.BindTexture(0, GL_TEXTURE_CUBE_MAP, m_ID);
     glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
 }
 
 void Cubemap::m_Load(const std::string& right, const std::string& left, const std::string& top, const std::string& bottom, const std::string& back, const std::string& front) {
-    glGenTextures(1, &m_ID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_ID);
-    
-    int width, height, nr_channels;
-    unsigned char* data = stbi_load(right.c_str(), &width, &height, &nr_channels, 0);
-    if (data) {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    } else {
-        std::cout << "Cubemap texture failed to load at path: " << right << '\n';
-    }
-    stbi_image_free(data);
-    
-    data = stbi_load(left.c_str(), &width, &height, &nr_channels, 0);
-    if (data) {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_X, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    } else {
-        std::cout << "Cubemap texture failed to load at path: " << left << '\n';
-    }
-    stbi_image_free(data);
-    
-    data = stbi_load(top.c_str(), &width, &height, &nr_channels, 0);
-    if (data) {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_Y, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    } else {
-        std::cout << "Cubemap texture failed to load at path: " << top << '\n';
-    }
-    stbi_image_free(data);
-    
-    data = stbi_load(bottom.c_str(), &width, &height, &nr_channels, 0);
-    if (data) {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_Y, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    } else {
-        std::cout << "Cubemap texture failed to load at path: " << bottom << '\n';
-    }
-    stbi_image_free(data);
-    
-    data = stbi_load(back.c_str(), &width, &height, &nr_channels, 0);
-    if (data) {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_Z, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    } else {
-        std::cout << "Cubemap texture failed to load at path: " << back << '\n';
-    }
-    stbi_image_free(data);
-    
-    data = stbi_load(front.c_str(), &width, &height, &nr_channels, 0);
-    if (data) {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_Z, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    } else {
-        std::cout << "Cubemap texture failed to load at path: " << front << '\n';
-    }
-    stbi_image_free(data);
-    
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    // Skybox is drawn with placeholder until faces are decoded and uploaded
+    m_ID = g_TextureLoader.LoadCubemap({ right, left, top, bottom, front, back });
 }
 
 void Cubemap::m_Initialize() {
@@ -132,18 +71,19 @@ void Cubemap::m_Initialize() {
          1.0f, -1.0f,  1.0f
     };
     
-    glGenVertexArrays(1, &m_VAO);
-    glGenBuffers(1, &m_VBO);
+    m_VAO = VertexArrayHandle::Create(GLResources::Owner::SKYBOX);
+    m_VBO = BufferHandle::Create(GLResources::Owner::SKYBOX);
     
-    glBindVertexArray(m_VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    g_GLState.BindVertexArray(m_VAO.ID());
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO.ID());
     
     // Position
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_STATIC_DRAW);
+    m_VBO.Bytes(sizeof(vertices));
     glEnableVertexAttribArray(0);
     
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     
-    glBindVertexArray(0);
+    g_GLState.BindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
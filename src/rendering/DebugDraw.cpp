@@ -0,0 +1,142 @@
+#include "DebugDraw.h"
+
+#include "GLState.h"
+
+#include <cstring>
+
+void DebugDraw::Initialize() {
+    m_Buffer.Initialize(GL_ARRAY_BUFFER, INITIAL_SIZE, GLResources::Owner::DEBUG);
+    m_VAO = VertexArrayHandle::Create(GLResources::Owner::DEBUG);
+}
+
+void DebugDraw::Destroy() {
+    m_Vertices.clear();
+    m_Previous.clear();
+    m_Buffer.Destroy();
+    m_VAO.Reset();
+}
+
+void DebugDraw::Enabled(bool enabled) {
+    m_Enabled = enabled;
+    if (!m_Enabled) {
+        m_Vertices.clear();
+    }
+}
+
+void DebugDraw::Line(const glm::vec3& start, const glm::vec3& end, const glm::vec3& color) {
+    if (!m_Enabled) {
+        return;
+    }
+
+    if (m_Vertices.size() + 2 > MAX_VERTICES) {
+        m_Dropped++;
+        return;
+    }
+
+    m_Vertices.push_back({ start, color });
+    m_Vertices.push_back({ end, color });
+}
+
+void DebugDraw::Box(const AABB& box, const glm::vec3& color) {
+    Box(box, glm::mat4(1.0f), color);
+}
+
+void DebugDraw::Box(const AABB& box, const glm::mat4& transform, const glm::vec3& color) {
+    if (!m_Enabled || box.Empty()) {
+        return;
+    }
+
+    std::array<glm::vec3, 8> corners;
+    for (int i = 0; i < 8; i++) {
+        glm::vec3 corner((i & 1) ? box.Max.x : box.Min.x, (i & 2) ? box.Max.y : box.Min.y, (i & 4) ? box.Max.z : box.Min.z);
+        corners[i] = glm::vec3(transform * glm::vec4(corner, 1.0f));
+    }
+
+    Edges(corners, color);
+}
+
+void DebugDraw::Axes(const glm::mat4& transform, float size) {
+    if (!m_Enabled) {
+        return;
+    }
+
+    glm::vec3 origin(transform[3]);
+    for (int axis = 0; axis < 3; axis++) {
+        glm::vec3 color(0.0f);
+        color[axis] = 1.0f;
+        Line(origin, origin + glm::vec3(transform[axis]) * size, color);
+    }
+}
+
+void DebugDraw::Frustum(const glm::mat4& pv, const glm::vec3& color) {
+    if (!m_Enabled) {
+        return;
+    }
+
+    // Corners of clip space cube taken back into world space
+    glm::mat4 inverse = glm::inverse(pv);
+    std::array<glm::vec3, 8> corners;
+    for (int i = 0; i < 8; i++) {
+        glm::vec4 corner = inverse * glm::vec4((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f, 1.0f);
+        corners[i] = glm::vec3(corner) / corner.w;
+    }
+
+    Edges(corners, color);
+}
+
+void DebugDraw::Edges(const std::array<glm::vec3, 8>& corners, const glm::vec3& color) {
+    // Every edge joins corners that differ in one bit
+    for (int i = 0; i < 8; i++) {
+        for (int bit = 1; bit < 8; bit <<= 1) {
+            if (!(i & bit)) {
+                Line(corners[i], corners[i | bit], color);
+            }
+        }
+    }
+}
+
+bool DebugDraw::Update() {
+    // Lines drawn by DrawManager itself are added after this, they change only with the scene
+    bool changed = m_Vertices != m_Previous;
+    m_Previous = m_Vertices;
+
+    return changed;
+}
+
+void DebugDraw::Flush(const ShaderProgram& shader) {
+    m_Flushed = m_Vertices.size();
+    if (m_Vertices.empty()) {
+        return;
+    }
+
+    GLsizeiptr size = static_cast<GLsizeiptr>(m_Vertices.size() * sizeof(Vertex));
+    m_Buffer.BeginFrame(size);
+    FrameRingBuffer::Allocation allocation = m_Buffer.Allocate(size);
+    if (allocation.Data != nullptr) {
+        std::memcpy(allocation.Data, m_Vertices.data(), size);
+    }
+    m_Buffer.Commit();
+
+    if (allocation.Data != nullptr) {
+        shader.Use();
+
+        // Region moves every frame, so attributes point at this frame's offset
+        g_GLState.BindVertexArray(m_VAO.ID());
+        glBindBuffer(GL_ARRAY_BUFFER, m_Buffer.Buffer());
+
+        // Position
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(allocation.Offset + offsetof(Vertex, Position)));
+        glEnableVertexAttribArray(0);
+        // Color
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(allocation.Offset + offsetof(Vertex, Color)));
+        glEnableVertexAttribArray(1);
+
+        glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(m_Vertices.size()));
+
+        g_GLState.BindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    m_Buffer.EndFrame();
+    m_Vertices.clear();
+}
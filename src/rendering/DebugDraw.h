@@ -0,0 +1,93 @@
+#ifndef DebugDraw_h
+#define DebugDraw_h
+
+#include "Bounds.h"
+#include "FrameRingBuffer.h"
+#include "GLResources.h"
+#include "ShaderProgram.h"
+
+#pragma warning(push, 0)
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#pragma warning(pop)
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Debug draw
+ *
+ * Immediate mode lines for visualizing axes, bounding volumes and frusta.
+ * Primitives can be added from anywhere during a frame, they are only
+ * appended as world space vertices to one array. DrawManager flushes the
+ * array once per drawn frame: it is copied into a streamed vertex buffer
+ * and drawn by a single GL_LINES call, then cleared, so primitives have to
+ * be added again every frame they should stay visible. Lines equal to the
+ * ones of the previous frame do not make the frame dirty.
+ */
+class DebugDraw {
+public:
+    // Vertices beyond the limit are dropped, protects against frames that are never flushed
+    static constexpr std::size_t MAX_VERTICES = 1 << 20;
+    static constexpr GLsizeiptr INITIAL_SIZE = 64 * 1024;
+
+    DebugDraw() = default;
+    DebugDraw(const DebugDraw&) = delete;
+    DebugDraw& operator=(const DebugDraw&) = delete;
+    DebugDraw(DebugDraw&&) = delete;
+    DebugDraw& operator=(DebugDraw&&) = delete;
+
+    // Has to be called with current context
+    void Initialize();
+    void Destroy();
+
+    // Disabled debug draw ignores added primitives
+    bool Enabled() const { return m_Enabled; }
+    void Enabled(bool enabled);
+
+    void Line(const glm::vec3& start, const glm::vec3& end, const glm::vec3& color);
+    void Box(const AABB& box, const glm::vec3& color);
+    // Box in local space of transform, stays oriented with it
+    void Box(const AABB& box, const glm::mat4& transform, const glm::vec3& color);
+    // Red, green and blue axes of transform, with given length in its local units
+    void Axes(const glm::mat4& transform, float size = 1.0f);
+    // Frustum of projection * view matrix
+    void Frustum(const glm::mat4& pv, const glm::vec3& color);
+
+    // True if lines added for this frame differ from the ones added for the previous frame
+    bool Update();
+    // Drops added lines of frame that is not drawn
+    void Discard() { m_Vertices.clear(); }
+
+    // Draws and clears added lines, Frame block has to be bound
+    void Flush(const ShaderProgram& shader);
+
+    std::size_t Flushed() const { return m_Flushed; }
+    std::size_t Dropped() const { return m_Dropped; }
+
+private:
+    // Matches attributes of PURE_COLOR.vert
+    struct Vertex {
+        glm::vec3 Position;
+        glm::vec3 Color;
+
+        bool operator==(const Vertex& other) const { return Position == other.Position && Color == other.Color; }
+    };
+
+    // Twelve edges of a box given by its corners, bits of index select max over min per axis
+    void Edges(const std::array<glm::vec3, 8>& corners, const glm::vec3& color);
+
+    bool m_Enabled{ true };
+    std::vector<Vertex> m_Vertices;
+    std::vector<Vertex> m_Previous;
+    std::size_t m_Flushed{ 0 };
+    std::size_t m_Dropped{ 0 };
+
+    FrameRingBuffer m_Buffer;
+    VertexArrayHandle m_VAO;
+};
+
+extern DebugDraw g_DebugDraw;
+
+#endif
@@ -2,9 +2,23 @@
 
 #include <imgui.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include "DebugDraw.h"
 #include "Drawable.h"
+#include "FontManager.h"
+#include "Frustum.h"
+#include "GLExtensions.h"
+#include "GLResources.h"
+#include "GLState.h"
 #include "IWidget.h"
+#include "TextureLoader.h"
 #include "ILightSource.h"
+#include "../utilities/Input.h"
+#include "../utilities/Time.h"
 #include "../utilities/Window.h"
 #include "../rendering/Cubemap.h"
 #include "../cbs/components/Camera.h"
@@ -17,24 +31,49 @@ void DrawManager::Initialize() {
     ImGui_ImplOpenGL3_Init("#version 330 core");
 
     // Load default font
-    ImGuiIO& io = ImGui::GetIO();
-    io.Fonts->AddFontDefault();
+    g_FontManager.Default();
 
-    // Create shader programs
-    m_ShaderPrograms[ShaderProgram::Type::PURE_COLOR].AttachShaders("resources/shaders/PURE_COLOR.vert",
-                                                                    "resources/shaders/PURE_COLOR.frag");
+    // Let driver compile programs on as many threads as it likes
+    if (g_GLExtensions.HasParallelShaderCompile()) {
+        g_GLExtensions.MaxShaderCompilerThreads(0xFFFFFFFF);
+    }
+
+    // Create shader programs, all are issued before waiting for any of them
+    m_ShaderPrograms[ShaderProgram::Type::PURE_COLOR].IssueShaders("resources/shaders/PURE_COLOR.vert",
+                                                                   "resources/shaders/PURE_COLOR.frag");
 
-    m_ShaderPrograms[ShaderProgram::Type::PURE_TEXTURE].AttachShaders("resources/shaders/PURE_TEXTURE.vert",
-                                                                      "resources/shaders/PURE_TEXTURE.frag");
+    m_ShaderPrograms[ShaderProgram::Type::PURE_TEXTURE].IssueShaders("resources/shaders/PURE_TEXTURE.vert",
+                                                                     "resources/shaders/PURE_TEXTURE.frag");
 
-    m_ShaderPrograms[ShaderProgram::Type::PHONG].AttachShaders("resources/shaders/PHONG.vert",
-                                                               "resources/shaders/PHONG.frag");
-    m_ShaderPrograms[ShaderProgram::Type::PHONG].Traits(ShaderProgram::Trait::LIGHT_RECEIVER);
+    // Light receivers are compiled for the lights and maps they meet, when they first meet them
+    m_Variants[ShaderProgram::Type::PHONG] = std::make_unique<ShaderVariants>("resources/shaders/PHONG.vert",
+                                                                             "resources/shaders/PHONG.frag",
+                                                                             ShaderProgram::Trait::LIGHT_RECEIVER);
 
-    m_ShaderPrograms[ShaderProgram::Type::SKYBOX].AttachShaders("resources/shaders/SKYBOX.vert",
-                                                                "resources/shaders/SKYBOX.frag");
+    m_ShaderPrograms[ShaderProgram::Type::SKYBOX].IssueShaders("resources/shaders/SKYBOX.vert",
+                                                               "resources/shaders/SKYBOX.frag");
 
-    glEnable(GL_DEPTH_TEST);
+    m_ShaderPrograms[ShaderProgram::Type::TEXT].IssueShaders("resources/shaders/TEXT.vert",
+                                                             "resources/shaders/TEXT.frag");
+
+    m_ShaderPrograms[ShaderProgram::Type::DEPTH].IssueShaders("resources/shaders/DEPTH.vert",
+                                                              "resources/shaders/DEPTH.frag");
+    m_ShaderPrograms[ShaderProgram::Type::DEPTH].Traits(ShaderProgram::Trait::DEPTH_ONLY);
+
+    m_ShaderPrograms[ShaderProgram::Type::DEBUG_LINES].IssueShaders("resources/shaders/DEBUG_LINES.vert",
+                                                                    "resources/shaders/PURE_COLOR.frag");
+
+    for (ShaderProgram& shader_program : m_ShaderPrograms) {
+        shader_program.FinishShaders();
+    }
+
+    g_GLState.DepthTest(true);
+    g_GLState.DepthFunc(GL_LESS);
+
+    m_FrameData.Initialize(GL_UNIFORM_BUFFER, FRAME_DATA_SIZE);
+    m_Timers.Initialize();
+    m_LightClusters.Initialize();
+    g_DebugDraw.Initialize();
 }
 
 void DrawManager::RegisterCamera(Camera *camera) {
@@ -47,10 +86,43 @@ Camera* DrawManager::MainCamera() const {
 
 void DrawManager::Skybox(const std::string& right, const std::string& left, const std::string& top, const std::string& bottom, const std::string& back, const std::string& front) {
     m_Skybox = std::make_unique<Cubemap>(right, left, top, bottom, back, front, ShaderProgram::Type::SKYBOX);
+    m_Dirty = true;
 }
 
 void DrawManager::Background(const glm::vec3& background) {
     m_Background = background;
+    m_Dirty = true;
+}
+
+void DrawManager::Depth(DepthStrategy strategy) {
+    m_Depth = strategy;
+    m_Dirty = true;
+}
+
+void DrawManager::ResolutionScaling(float min_scale, float max_scale, float target_frame_rate) {
+    m_Resolution = std::make_unique<DynamicResolution>(min_scale, max_scale, target_frame_rate);
+    m_SceneTarget = std::make_unique<Framebuffer>(1, 1);
+    m_Dirty = true;
+}
+
+void DrawManager::Offscreen(unsigned int width, unsigned int height) {
+    m_Offscreen = std::make_unique<Framebuffer>(width, height);
+    m_Dirty = true;
+}
+
+void DrawManager::ShowStatistics(bool show) {
+    m_ShowStatistics = show;
+    m_Dirty = true;
+}
+
+void DrawManager::ShowMemory(bool show) {
+    m_ShowMemory = show;
+    m_Dirty = true;
+}
+
+void DrawManager::ShowBounds(bool show) {
+    m_ShowBounds = show;
+    m_Dirty = true;
 }
 
 void DrawManager::RegisterDrawCall(Drawable* component) {
@@ -58,14 +130,33 @@ void DrawManager::RegisterDrawCall(Drawable* component) {
     assert(std::find(m_Drawables.begin(), m_Drawables.end(), component) == m_Drawables.end());
 
     m_Drawables.push_back(component);
+    m_Proxies.push_back(BoundingVolumeHierarchy::NULL_NODE);
+    m_Dirty = true;
 }
 
 void DrawManager::UnregisterDrawCall(Drawable* component) {
     // Unregistering not registered component has no effect
     auto to_erase = std::find(m_Drawables.begin(), m_Drawables.end(), component);
-    if (to_erase != m_Drawables.end()) {
-        m_Drawables.erase(to_erase);
+    if (to_erase == m_Drawables.end()) {
+        return;
+    }
+
+    std::size_t index = to_erase - m_Drawables.begin();
+    if (m_Proxies[index] != BoundingVolumeHierarchy::NULL_NODE) {
+        m_BoundingVolumes.Remove(m_Proxies[index]);
     }
+
+    m_Drawables.erase(to_erase);
+    m_Proxies.erase(m_Proxies.begin() + index);
+
+    // Proxies of following drawables refer to shifted indices
+    for (std::size_t i = index; i < m_Proxies.size(); i++) {
+        if (m_Proxies[i] != BoundingVolumeHierarchy::NULL_NODE) {
+            m_BoundingVolumes.UserData(m_Proxies[i], static_cast<int>(i));
+        }
+    }
+
+    m_Dirty = true;
 }
 
 void DrawManager::RegisterWidget(IWidget* widget) {
@@ -73,6 +164,7 @@ void DrawManager::RegisterWidget(IWidget* widget) {
     assert(std::find(m_Widgets.begin(), m_Widgets.end(), widget) == m_Widgets.end());
 
     m_Widgets.push_back(widget);
+    m_Dirty = true;
 }
 
 void DrawManager::UnregisterWidget(IWidget* widget) {
@@ -80,6 +172,7 @@ void DrawManager::UnregisterWidget(IWidget* widget) {
     auto to_erase = std::find(m_Widgets.begin(), m_Widgets.end(), widget);
     if (to_erase != m_Widgets.end()) {
         m_Widgets.erase(to_erase);
+        m_Dirty = true;
     }
 }
 
@@ -88,6 +181,7 @@ void DrawManager::RegisterLightSource(ILightSource* light_source) {
     assert(std::find(m_LightSources.begin(), m_LightSources.end(), light_source) == m_LightSources.end());
 
     m_LightSources.push_back(light_source);
+    m_Dirty = true;
 }
 
 void DrawManager::UnregisterLightSource(ILightSource* light_source) {
@@ -95,136 +189,614 @@ void DrawManager::UnregisterLightSource(ILightSource* light_source) {
     auto to_erase = std::find(m_LightSources.begin(), m_LightSources.end(), light_source);
     if (to_erase != m_LightSources.end()) {
         m_LightSources.erase(to_erase);
+        m_Dirty = true;
     }
 }
 
-void DrawManager::CallDraws() const {
-    glClearColor(m_Background.x, m_Background.y, m_Background.z, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+bool DrawManager::CallDraws() {
+    // Objects released since the last frame, also when this one is skipped
+    g_GLResources.Collect();
+    // Read-backs of earlier frames finish while nothing is drawn too
+    m_Capture.Collect(false);
+
+    if (g_TextureLoader.Update()) {
+        m_Dirty = true;
+    }
+    if (g_DebugDraw.Update()) {
+        m_Dirty = true;
+    }
 
     glm::mat4 pv = m_Camera->Projection() * m_Camera->ViewMatrix(); // camera to clip * world to camera --> overall world to clip
 
-    // Draw objects
-    for (auto to_draw = m_Drawables.cbegin(); to_draw != m_Drawables.cend(); to_draw++) {
-        int shader_type = (*to_draw)->ShaderType();
-        const ShaderProgram& curr_shader = m_ShaderPrograms[shader_type];
+    bool changed = Dirty() || pv != m_DrawnPv || m_DrawnModels.size() != m_Drawables.size();
+    for (std::size_t i = 0; !changed && i < m_Drawables.size(); i++) {
+        changed = m_Drawables[i]->Model() != m_DrawnModels[i];
+    }
+    if (!changed) {
+        g_DebugDraw.Discard();
+        m_SkippedFrames++;
+        return false;
+    }
 
-        curr_shader.Use();
-        curr_shader.Uniform("pv", pv);
+    m_DrawnPv = pv;
+    m_DrawnModels.resize(m_Drawables.size());
+    for (std::size_t i = 0; i < m_Drawables.size(); i++) {
+        m_DrawnModels[i] = m_Drawables[i]->Model();
+    }
+
+    PrepareDraws(nullptr);
+    Cull(pv);
+    OrderDraws();
+    ScaleResolution();
+    GatherLights(m_Camera->ViewMatrix(), m_Camera->Projection());
+    PrewarmVariants();
+    SubmitDraws(pv, m_Camera->Projection() * glm::mat4(glm::mat3(m_Camera->ViewMatrix())), m_Camera->Object().Root().Position());
+
+    return true;
+}
 
-        // For each trait in shader set corresponding properties 
-        if (curr_shader.Traits() & ShaderProgram::Trait::LIGHT_RECEIVER) {
-            curr_shader.Uniform("viewPos", m_Camera->Object().Root().Position());
-            curr_shader.Uniform("material.shininess", 32.0f);
+bool DrawManager::NetworkCallDraws(DrawingSnapshot *drawing_snapshot) {
+    // Objects released since the last frame, also when this one is skipped
+    g_GLResources.Collect();
+    // Read-backs of earlier frames finish while nothing is drawn too
+    m_Capture.Collect(false);
 
-            for (auto light_source = m_LightSources.begin(); light_source != m_LightSources.end(); ++light_source) {
-                (*light_source)->SetLightProperties(curr_shader);
+    if (g_TextureLoader.Update()) {
+        m_Dirty = true;
+    }
+    if (g_DebugDraw.Update()) {
+        m_Dirty = true;
+    }
+
+    // Server keeps sending snapshots even if nothing moves
+    if (!Dirty() && std::memcmp(&m_DrawnSnapshot, drawing_snapshot, sizeof(DrawingSnapshot)) == 0) {
+        g_DebugDraw.Discard();
+        m_SkippedFrames++;
+        return false;
+    }
+    std::memcpy(&m_DrawnSnapshot, drawing_snapshot, sizeof(DrawingSnapshot));
+
+    // glm::mat4 pv = m_Camera->Projection() * m_Camera->ViewMatrix();
+    glm::mat4 world_to_camera = glm::make_mat4(drawing_snapshot->world_to_camera.data());
+    glm::mat4 camera_to_clip = glm::make_mat4(drawing_snapshot->camera_to_clip.data());
+
+    glm::mat4 pv = camera_to_clip * world_to_camera;
+
+    glm::vec3 camera_pos = glm::make_vec3(drawing_snapshot->camera_pos.data());
+
+    PrepareDraws(drawing_snapshot);
+    Cull(pv);
+    OrderDraws();
+    ScaleResolution();
+    GatherLights(world_to_camera, camera_to_clip);
+    PrewarmVariants();
+    SubmitDraws(pv, camera_to_clip * glm::mat4(glm::mat3(world_to_camera)), camera_pos);
+
+    return true;
+}
+
+bool DrawManager::Dirty() const {
+    // Statistics and memory accounts change every frame, recording keeps constant frame rate
+    if (m_Dirty || m_ShowStatistics || m_ShowMemory || m_Capture.Recording() || m_Capture.Pending() || g_Window.Width() != m_DrawnWidth || g_Window.Height() != m_DrawnHeight) {
+        return true;
+    }
+
+    return std::any_of(m_Widgets.begin(), m_Widgets.end(), [](const IWidget* widget) { return widget->Changed(); });
+}
+
+void DrawManager::PrepareDraws(const DrawingSnapshot* drawing_snapshot) {
+    m_PacketBuffers.resize(m_Workers.Size());
+
+    // Model matrices are copied by workers straight into the frame's region
+    GLsizeiptr object_stride = m_FrameData.Aligned(sizeof(glm::mat4));
+    GLsizeiptr objects_size = object_stride * static_cast<GLsizeiptr>(m_Drawables.size());
+    m_FrameData.BeginFrame(m_FrameData.Aligned(sizeof(FrameBlock)) + objects_size);
+    FrameRingBuffer::Allocation objects = m_FrameData.Allocate(objects_size);
+
+    // Workers with empty ranges are not called, so every buffer is cleared up front
+    for (std::vector<DrawPacket>& packets : m_PacketBuffers) {
+        packets.clear();
+    }
+
+    auto prepare = [&](std::size_t begin, std::size_t end, unsigned int worker) {
+        std::vector<DrawPacket>& packets = m_PacketBuffers[worker];
+
+        for (std::size_t i = begin; i < end; i++) {
+            DrawPacket packet;
+            packet.ToDraw = m_Drawables[i];
+            packet.Shader = packet.ToDraw->ShaderType();
+
+            /**
+             * ASSUMPTION: THIS ONLY WORKS BECAUSE SERVER AND CLIENT ITERATE OVER
+             * DRAWABLES IN THE SAME ORDER
+             */
+            if (drawing_snapshot != nullptr) {
+                packet.Model = packet.ToDraw->NetworkModel(glm::make_mat4((drawing_snapshot->local_to_world_matrices[i]).data()));
+            } else {
+                packet.Model = packet.ToDraw->Model();
             }
+
+            packet.HasBounds = packet.ToDraw->WorldBounds(packet.Model, &packet.Bounds);
+
+            packet.ObjectOffset = objects.Offset + object_stride * static_cast<GLintptr>(i);
+            if (objects.Data != nullptr) {
+                std::memcpy(objects.Data + object_stride * i, &packet.Model[0][0], sizeof(glm::mat4));
+            }
+
+            packets.push_back(packet);
         }
+    };
 
-        (*to_draw)->Draw(curr_shader);
+    // Waking workers costs more than it saves in small scenes
+    if (m_Drawables.size() < PARALLEL_PREPARE_THRESHOLD) {
+        prepare(0, m_Drawables.size(), 0);
+    } else {
+        m_Workers.ParallelFor(m_Drawables.size(), prepare);
     }
 
-    // Draw skybox
-    if (m_Skybox != nullptr) {
-        glDepthFunc(GL_LEQUAL);
-        const ShaderProgram& skybox_shader = m_ShaderPrograms[ShaderProgram::Type::SKYBOX];
+    // Ranges are contiguous, so merging buffers in worker order keeps packets aligned with drawables
+    m_Packets.clear();
+    for (const std::vector<DrawPacket>& packets : m_PacketBuffers) {
+        m_Packets.insert(m_Packets.end(), packets.begin(), packets.end());
+    }
+}
 
-        skybox_shader.Use();
-        skybox_shader.Uniform("pv", m_Camera->Projection() * glm::mat4(glm::mat3(m_Camera->ViewMatrix())));
+void DrawManager::Cull(const glm::mat4& pv) {
+    // Move proxies of drawables that left their fat boxes
+    for (std::size_t i = 0; i < m_Packets.size(); i++) {
+        DrawPacket& packet = m_Packets[i];
+        int& proxy = m_Proxies[i];
+        if (!packet.HasBounds) {
+            if (proxy != BoundingVolumeHierarchy::NULL_NODE) {
+                m_BoundingVolumes.Remove(proxy);
+                proxy = BoundingVolumeHierarchy::NULL_NODE;
+            }
 
-        m_Skybox->Draw(skybox_shader);
+            // Drawables without bounds are never culled
+            packet.Visible = true;
+            continue;
+        }
 
-        glDepthFunc(GL_LESS);
+        if (proxy == BoundingVolumeHierarchy::NULL_NODE) {
+            proxy = m_BoundingVolumes.Insert(packet.Bounds, static_cast<int>(i));
+        } else {
+            m_BoundingVolumes.Update(proxy, packet.Bounds);
+        }
+        packet.Visible = false;
     }
-    
-    // Draw GUI
-    ImGui_ImplOpenGL3_NewFrame();
-    ImGui_ImplGlfw_NewFrame();
-    ImGui::NewFrame();
 
-    for (auto widget = m_Widgets.begin(); widget != m_Widgets.end(); widget++) {
-        (*widget)->Draw();
+    // Leaves hold fat boxes, so candidates are tested once more with exact bounds
+    Frustum frustum(pv);
+    m_BoundingVolumes.Query(frustum, [&](int index) {
+        DrawPacket& packet = m_Packets[index];
+        packet.Visible = frustum.Visible(packet.Bounds);
+        if (packet.Visible) {
+            BoundingSphere sphere = packet.Bounds.Sphere();
+            packet.ScreenSize = ScreenSize(pv, sphere);
+            packet.Depth = (pv * glm::vec4(sphere.Center, 1.0f)).w;
+        }
+    });
+
+    m_Culling.Visible = std::count_if(m_Packets.begin(), m_Packets.end(), [](const DrawPacket& packet) { return packet.Visible; });
+    m_Culling.Culled = m_Packets.size() - m_Culling.Visible;
+}
+
+void DrawManager::OrderDraws() {
+    m_DrawOrder.clear();
+    for (std::size_t i = 0; i < m_Packets.size(); i++) {
+        if (m_Packets[i].Visible) {
+            m_DrawOrder.push_back(i);
+        }
     }
 
-    ImGui::Render();
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-    ImGui::EndFrame();
+    if (m_Depth == DepthStrategy::NONE) {
+        return;
+    }
 
-    // End of drawing
-    glfwSwapBuffers(g_Window);
+    // Drawables without bounds may be anywhere, they go last and keep their order
+    std::stable_sort(m_DrawOrder.begin(), m_DrawOrder.end(), [&](std::size_t lhs, std::size_t rhs) {
+        const DrawPacket& left = m_Packets[lhs];
+        const DrawPacket& right = m_Packets[rhs];
+        if (left.HasBounds != right.HasBounds) {
+            return left.HasBounds;
+        }
+        return left.HasBounds && left.Depth < right.Depth;
+    });
+}
+
+float DrawManager::ScreenSize(const glm::mat4& pv, const BoundingSphere& sphere) {
+    // Second row of pv is the vertical projection scale times unit vector of view rotation,
+    // so its length is the scale whatever the camera orientation
+    float scale = glm::length(glm::vec3(pv[0][1], pv[1][1], pv[2][1]));
+    float depth = (pv * glm::vec4(sphere.Center, 1.0f)).w;
+
+    // Camera inside the sphere sees it fill the screen
+    if (depth <= sphere.Radius) {
+        return 1.0f;
+    }
+
+    return std::min(1.0f, sphere.Radius * scale / depth);
 }
 
-void DrawManager::NetworkCallDraws(DrawingSnapshot *drawing_snapshot) const {
+void DrawManager::ScaleResolution() {
+    m_SceneWidth = g_Window.Width();
+    m_SceneHeight = g_Window.Height();
+    // Offscreen frames are dumped and compared, they are always drawn at full resolution
+    if (m_Resolution == nullptr || m_Offscreen != nullptr) {
+        return;
+    }
+
+    if (m_Timers.CollectedFrames() != m_ScaledFrames) {
+        m_ScaledFrames = m_Timers.CollectedFrames();
+
+        float scene_time = m_Timers.LastFrame(GPUTimers::Pass::DEPTH) + m_Timers.LastFrame(GPUTimers::Pass::DRAWABLES)
+                         + m_Timers.LastFrame(GPUTimers::Pass::SKYBOX);
+        float fixed_time = m_Timers.LastFrame(GPUTimers::Pass::UPSCALE) + m_Timers.LastFrame(GPUTimers::Pass::UI);
+        m_Resolution->Update(scene_time, fixed_time);
+    }
+
+    // Target has room for the largest scale, so changing scale never reallocates it
+    float max_scale = m_Resolution->MaxScale();
+    m_SceneTarget->Resize(std::max(1u, static_cast<unsigned int>(std::ceil(m_SceneWidth * max_scale))),
+                          std::max(1u, static_cast<unsigned int>(std::ceil(m_SceneHeight * max_scale))));
+
+    float scale = m_Resolution->Scale();
+    m_SceneWidth = std::clamp(static_cast<unsigned int>(std::lround(m_SceneWidth * scale)), 1u, m_SceneTarget->Width());
+    m_SceneHeight = std::clamp(static_cast<unsigned int>(std::lround(m_SceneHeight * scale)), 1u, m_SceneTarget->Height());
+}
+
+void DrawManager::GatherLights(const glm::mat4& view, const glm::mat4& projection) {
+    m_LightDefines = ShaderVariants::Defines();
+    m_LightClusters.Clear();
+    for (const ILightSource* light_source : m_LightSources) {
+        switch (light_source->LightKind()) {
+        case ILightSource::Kind::DIRECTIONAL:
+            m_LightDefines.DirLights++;
+            break;
+        case ILightSource::Kind::POINT:
+            m_LightDefines.PointLights = true;
+            break;
+        case ILightSource::Kind::SPOT:
+            m_LightDefines.SpotLights++;
+            break;
+        }
+
+        light_source->AddToClusters(m_LightClusters);
+    }
+
+    m_LightClusters.Build(view, projection, m_SceneWidth, m_SceneHeight);
+
+    unsigned int ignored = m_LightDefines.DirLights - std::min(m_LightDefines.DirLights, ShaderVariants::MAX_DIR_LIGHTS)
+                         + m_LightDefines.SpotLights - std::min(m_LightDefines.SpotLights, ShaderVariants::MAX_SPOT_LIGHTS);
+    if (ignored != m_IgnoredLights && ignored != 0) {
+        std::cout << "DrawManager: " << ignored << " directional and spot lights over the limits of "
+                  << ShaderVariants::MAX_DIR_LIGHTS << " and " << ShaderVariants::MAX_SPOT_LIGHTS << " are ignored" << '\n';
+    }
+    m_IgnoredLights = ignored;
+}
+
+void DrawManager::PrewarmVariants() {
+    std::vector<ShaderVariants::Defines> defines;
+    for (std::size_t type = 0; type < m_Variants.size(); type++) {
+        if (m_Variants[type] == nullptr) {
+            continue;
+        }
+
+        defines.clear();
+        for (std::size_t index : m_DrawOrder) {
+            const DrawPacket& packet = m_Packets[index];
+            if (static_cast<std::size_t>(packet.Shader) != type) {
+                continue;
+            }
+
+            ShaderVariants::Defines packet_defines = m_LightDefines;
+            packet_defines.Maps = packet.ToDraw->MaterialMaps();
+            if (std::none_of(defines.begin(), defines.end(), [&](const ShaderVariants::Defines& known) { return known.Key() == packet_defines.Key(); })) {
+                defines.push_back(packet_defines);
+            }
+        }
+        m_Variants[type]->Prewarm(defines);
+    }
+}
+
+const ShaderProgram& DrawManager::Program(const DrawPacket& packet) {
+    if (m_Variants[packet.Shader] == nullptr) {
+        return m_ShaderPrograms[packet.Shader];
+    }
+
+    ShaderVariants::Defines defines = m_LightDefines;
+    defines.Maps = packet.ToDraw->MaterialMaps();
+    return m_Variants[packet.Shader]->Variant(defines);
+}
+
+void DrawManager::SubmitDraws(const glm::mat4& pv, const glm::mat4& skybox_pv, const glm::vec3& view_pos) {
+    if (m_Offscreen != nullptr) {
+        m_Offscreen->Resize(g_Window.Width(), g_Window.Height());
+    }
+
+    bool scaled = m_SceneTarget != nullptr && (m_SceneWidth != g_Window.Width() || m_SceneHeight != g_Window.Height());
+    if (scaled) {
+        m_SceneTarget->Bind(m_SceneWidth, m_SceneHeight);
+    } else if (m_Offscreen != nullptr) {
+        m_Offscreen->Bind();
+    }
+
+    // Masks also apply to clearing
+    g_GLState.DepthMask(true);
+    g_GLState.ColorMask(true);
     glClearColor(m_Background.x, m_Background.y, m_Background.z, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // glm::mat4 pv = m_Camera->Projection() * m_Camera->ViewMatrix();
-    glm::mat4 world_to_camera = glm::make_mat4(drawing_snapshot->world_to_camera.data());
-    glm::mat4 camera_to_clip = glm::make_mat4(drawing_snapshot->camera_to_clip.data());
+    m_Timers.BeginFrame();
 
-    glm::mat4 pv = camera_to_clip * world_to_camera;
+    FrameBlock frame{ pv, skybox_pv, glm::vec4(view_pos, 1.0f) };
+    FrameRingBuffer::Allocation frame_data = m_FrameData.Allocate(sizeof(FrameBlock));
+    if (frame_data.Data != nullptr) {
+        std::memcpy(frame_data.Data, &frame, sizeof(FrameBlock));
+    }
+    m_FrameData.Commit();
 
-    glm::vec3 camera_pos = glm::make_vec3(drawing_snapshot->camera_pos.data());
+    glBindBufferRange(GL_UNIFORM_BUFFER, ShaderProgram::UniformBlock::FRAME_BLOCK, m_FrameData.Buffer(), frame_data.Offset, sizeof(FrameBlock));
 
-    // Draw objects
-    unsigned int i = 0;
-    for (auto to_draw = m_Drawables.cbegin(); to_draw != m_Drawables.cend(); to_draw++) {
-        int shader_type = (*to_draw)->ShaderType();
-        const ShaderProgram& curr_shader = m_ShaderPrograms[shader_type];
+    // Uniforms shared by all objects are set once per program in a frame
+    std::vector<const ShaderProgram*> prepared;
 
-        curr_shader.Use();
-        curr_shader.Uniform("pv", pv);
+    // Level of detail has to be the same in both passes of pre-pass
+    for (std::size_t index : m_DrawOrder) {
+        const DrawPacket& packet = m_Packets[index];
+        if (packet.HasBounds) {
+            packet.ToDraw->ScreenSize(packet.ScreenSize);
+        }
+    }
+
+    // Lay down depth of all opaque drawables with the cheapest program
+    if (m_Depth == DepthStrategy::PREPASS) {
+        m_Timers.Begin(GPUTimers::Pass::DEPTH);
+        g_GLState.ColorMask(false);
+
+        const ShaderProgram& depth_shader = m_ShaderPrograms[ShaderProgram::Type::DEPTH];
+        depth_shader.Use();
+        for (std::size_t index : m_DrawOrder) {
+            const DrawPacket& packet = m_Packets[index];
+            glBindBufferRange(GL_UNIFORM_BUFFER, ShaderProgram::UniformBlock::OBJECT_BLOCK, m_FrameData.Buffer(), packet.ObjectOffset, sizeof(glm::mat4));
+            packet.ToDraw->Draw(depth_shader);
+        }
+
+        // Only the nearest fragment of every pixel passes, depth is final already
+        g_GLState.ColorMask(true);
+        g_GLState.DepthMask(false);
+        g_GLState.DepthFunc(GL_EQUAL);
+        m_Timers.End(GPUTimers::Pass::DEPTH);
+    }
 
-        // For each trait in shader set corresponding properties 
-        if (curr_shader.Traits() & ShaderProgram::Trait::LIGHT_RECEIVER) {
-            // curr_shader.Uniform("viewPos", m_Camera->Object().Root().Position());
-            curr_shader.Uniform("viewPos", camera_pos);
-            curr_shader.Uniform("material.shininess", 32.0f);
+    // Draw objects
+    m_Timers.Begin(GPUTimers::Pass::DRAWABLES);
+    for (std::size_t index : m_DrawOrder) {
+        const DrawPacket& packet = m_Packets[index];
+        const ShaderProgram& curr_shader = Program(packet);
+        curr_shader.Use();
 
-            for (auto light_source = m_LightSources.begin(); light_source != m_LightSources.end(); ++light_source) {
-                (*light_source)->SetLightProperties(curr_shader);
+        if (std::find(prepared.begin(), prepared.end(), &curr_shader) == prepared.end()) {
+            // For each trait in shader set corresponding properties 
+            if (curr_shader.Traits() & ShaderProgram::Trait::LIGHT_RECEIVER) {
+                curr_shader.Uniform("material.shininess", 32.0f);
+
+                // Lights of each kind fill their own uniform array, lights past its end are ignored
+                unsigned int indices[3] = { 0, 0, 0 };
+                const unsigned int limits[3] = { ShaderVariants::MAX_DIR_LIGHTS, LightClusters::MAX_LIGHTS, ShaderVariants::MAX_SPOT_LIGHTS };
+                for (auto light_source = m_LightSources.begin(); light_source != m_LightSources.end(); ++light_source) {
+                    int kind = static_cast<int>((*light_source)->LightKind());
+                    if (indices[kind] < limits[kind]) {
+                        (*light_source)->SetLightProperties(curr_shader, indices[kind]++);
+                    }
+                }
+                m_LightClusters.Bind(curr_shader);
             }
+
+            prepared.push_back(&curr_shader);
         }
 
-        /**
-         * ASSUMPTION: THIS ONLY WORKS BECAUSE SERVER AND CLIENT ITERATE OVER
-         * DRAWABLES IN THE SAME ORDER
-         */        
-        glm::mat4 local_to_world = glm::make_mat4((drawing_snapshot->local_to_world_matrices[i]).data());
-        (*to_draw)->NetworkDraw(curr_shader, local_to_world);
+        glBindBufferRange(GL_UNIFORM_BUFFER, ShaderProgram::UniformBlock::OBJECT_BLOCK, m_FrameData.Buffer(), packet.ObjectOffset, sizeof(glm::mat4));
+        packet.ToDraw->Draw(curr_shader);
+    }
 
-        i++;
+    // Debug lines are tested against depth of the scene, but do not take part in pre-pass
+    if (m_ShowBounds) {
+        for (std::size_t index : m_DrawOrder) {
+            if (m_Packets[index].HasBounds) {
+                g_DebugDraw.Box(m_Packets[index].Bounds, glm::vec3(0.0f, 1.0f, 0.0f));
+            }
+        }
     }
+    if (m_Depth == DepthStrategy::PREPASS) {
+        g_GLState.DepthMask(true);
+        g_GLState.DepthFunc(GL_LESS);
+    }
+    g_DebugDraw.Flush(m_ShaderPrograms[ShaderProgram::Type::DEBUG_LINES]);
+    m_Timers.End(GPUTimers::Pass::DRAWABLES);
 
     // Draw skybox
     if (m_Skybox != nullptr) {
-        glDepthFunc(GL_LEQUAL);
+        m_Timers.Begin(GPUTimers::Pass::SKYBOX);
+        g_GLState.DepthFunc(GL_LEQUAL);
         const ShaderProgram& skybox_shader = m_ShaderPrograms[ShaderProgram::Type::SKYBOX];
 
         skybox_shader.Use();
-        // skybox_shader.Uniform("pv", m_Camera->Projection() * glm::mat4(glm::mat3(m_Camera->ViewMatrix())));
-        skybox_shader.Uniform("pv", camera_to_clip * glm::mat4(glm::mat3(world_to_camera)));
-
         m_Skybox->Draw(skybox_shader);
 
-        glDepthFunc(GL_LESS);
+        g_GLState.DepthFunc(GL_LESS);
+        m_Timers.End(GPUTimers::Pass::SKYBOX);
+    }
+
+    // Stretch the scene over the window, GUI is drawn over it at native resolution
+    if (scaled) {
+        m_Timers.Begin(GPUTimers::Pass::UPSCALE);
+        GLuint destination = m_Offscreen != nullptr ? m_Offscreen->ID() : 0;
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, m_SceneTarget->ID());
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, destination);
+        glBlitFramebuffer(0, 0, m_SceneWidth, m_SceneHeight, 0, 0, g_Window.Width(), g_Window.Height(), GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, destination);
+        glViewport(0, 0, g_Window.Width(), g_Window.Height());
+        m_Timers.End(GPUTimers::Pass::UPSCALE);
     }
+
+    // Region can be reused once GPU gets past this point
+    m_FrameData.EndFrame();
     
-    // Draw GUI
-    ImGui_ImplOpenGL3_NewFrame();
-    ImGui_ImplGlfw_NewFrame();
-    ImGui::NewFrame();
+    // Draw GUI, atlas cannot change once the frame starts
+    g_FontManager.Update();
+
+    // Static ImGui output is submitted again without building the frame
+    if (!UIChanged()) {
+        m_Timers.Begin(GPUTimers::Pass::UI);
+        DrawRetainedWidgets();
+        ImGui_ImplOpenGL3_RenderDrawData(m_UICache.Replay());
+        m_Timers.End(GPUTimers::Pass::UI);
+    } else {
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        ImGui::NewFrame();
+
+        m_Timers.Begin(GPUTimers::Pass::UI);
+        DrawRetainedWidgets();
+
+        for (auto widget = m_Widgets.begin(); widget != m_Widgets.end(); widget++) {
+            if (!(*widget)->Retained()) {
+                (*widget)->Draw();
+            }
+        }
+
+        if (m_ShowStatistics) {
+            DrawStatistics();
+        }
 
-    for (auto widget = m_Widgets.begin(); widget != m_Widgets.end(); widget++) {
-        // TODO: pass in text for TextRenderer
-        (*widget)->Draw();
+        if (m_ShowMemory) {
+            DrawMemory();
+        }
+
+        ImGui::Render();
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        m_Timers.End(GPUTimers::Pass::UI);
+        ImGui::EndFrame();
+
+        m_UICache.Store(*ImGui::GetDrawData(), g_Window.Width(), g_Window.Height(), g_FontManager.Generation());
     }
 
-    ImGui::Render();
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-    ImGui::EndFrame();
+    // Dear ImGui backend changes GL state directly
+    g_GLState.Invalidate();
+
+    // Read back is queued before present, so it reads this frame
+    m_Capture.Capture(m_Offscreen != nullptr ? m_Offscreen->ID() : 0, g_Window.Width(), g_Window.Height());
 
     // End of drawing
-    glfwSwapBuffers(g_Window);
+    if (m_Offscreen == nullptr) {
+        glfwSwapBuffers(g_Window);
+    }
+
+    m_Dirty = false;
+    m_DrawnWidth = g_Window.Width();
+    m_DrawnHeight = g_Window.Height();
+    for (IWidget* widget : m_Widgets) {
+        widget->ClearChanged();
+    }
+}
+
+void DrawManager::DrawMemory() const {
+    ImGui::SetNextWindowPos(ImVec2(10.0f, 300.0f), ImGuiCond_FirstUseEver);
+    ImGui::Begin("GPU memory", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings);
+
+    auto row = [](const char* name, const GLResources::Usage& usage) {
+        ImGui::Text("%-14s %7zu %9.2f %9.2f", name, usage.Live, usage.Bytes / MEGABYTE, usage.Peak / MEGABYTE);
+    };
+
+    ImGui::Text("%-14s %7s %9s %9s", "Kind", "objects", "MB", "peak MB");
+    for (int kind = 0; kind < GLResources::Kind::COUNT; kind++) {
+        row(GLResources::Name(static_cast<GLResources::Kind>(kind)), g_GLResources.Stats(static_cast<GLResources::Kind>(kind)));
+    }
+
+    ImGui::Separator();
+    ImGui::Text("%-14s %7s %9s %9s", "Owner", "objects", "MB", "peak MB");
+    for (int owner = 0; owner < static_cast<int>(GLResources::Owner::COUNT); owner++) {
+        row(GLResources::Name(static_cast<GLResources::Owner>(owner)), g_GLResources.Stats(static_cast<GLResources::Owner>(owner)));
+    }
+
+    ImGui::Separator();
+    row("Total", g_GLResources.Total());
+    ImGui::Text("Released, waiting for deletion %zu", g_GLResources.Pending());
+
+    ImGui::End();
+}
+
+bool DrawManager::UIChanged() const {
+    // Statistics change every frame, input may interact with ImGui windows
+    if (m_ShowStatistics || m_ShowMemory || g_Input.Active() || !m_UICache.Valid(g_Window.Width(), g_Window.Height(), g_FontManager.Generation())) {
+        return true;
+    }
+
+    // Retained widgets are drawn every frame from their own buffers
+    return std::any_of(m_Widgets.begin(), m_Widgets.end(), [](const IWidget* widget) {
+        return !widget->Retained() && widget->Changed();
+    });
+}
+
+void DrawManager::DrawRetainedWidgets() const {
+    // Font texture exists once ImGui frame has started
+    const ShaderProgram& text_shader = m_ShaderPrograms[ShaderProgram::Type::TEXT];
+    text_shader.Use();
+
+    g_GLState.DepthTest(false);
+    g_GLState.Blend(true);
+    g_GLState.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    for (const IWidget* widget : m_Widgets) {
+        if (widget->Retained()) {
+            widget->DrawRetained(text_shader);
+        }
+    }
+
+    // Dear ImGui backend restores the state it finds, scene expects these
+    g_GLState.Blend(false);
+    g_GLState.DepthTest(true);
+}
+
+void DrawManager::DrawStatistics() const {
+    ImGui::SetNextWindowPos(ImVec2(10.0f, 10.0f), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Statistics", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings);
+
+    ImGui::Text("CPU frame %.2f ms", g_Time.DeltaTime() * 1000.0f);
+
+    ImGui::Separator();
+    ImGui::Text("GPU pass       avg ms   p99 ms");
+    for (int pass = 0; pass < GPUTimers::Pass::COUNT; pass++) {
+        GPUTimers::Timing timing = m_Timers.Statistics(static_cast<GPUTimers::Pass>(pass));
+        ImGui::Text("%-12s %8.3f %8.3f", GPUTimers::Name(static_cast<GPUTimers::Pass>(pass)), timing.Average, timing.P99);
+    }
+
+    ImGui::Separator();
+    ImGui::Text("Drawables %zu visible, %zu culled", m_Culling.Visible, m_Culling.Culled);
+    const char* depth_strategies[] = { "none", "front to back", "pre-pass" };
+    ImGui::Text("Depth strategy %s", depth_strategies[static_cast<int>(m_Depth)]);
+    ImGui::Text("Scene %ux%u, %.0f%% of window", m_SceneWidth, m_SceneHeight, ResolutionScale() * 100.0f);
+    ImGui::Text("Lights %zu, %zu cluster assignments", m_LightClusters.Lights(), m_LightClusters.Assignments());
+    std::size_t variants = 0;
+    for (const std::unique_ptr<ShaderVariants>& type_variants : m_Variants) {
+        variants += type_variants != nullptr ? type_variants->Compiled() : 0;
+    }
+    ImGui::Text("Shader variants %zu compiled", variants);
+    ImGui::Text("Debug lines %zu", g_DebugDraw.Flushed() / 2);
+    ImGui::Text("GL calls %llu issued, %llu skipped",
+                static_cast<unsigned long long>(g_GLState.Issued()),
+                static_cast<unsigned long long>(g_GLState.Skipped()));
+    GLResources::Usage memory = g_GLResources.Total();
+    ImGui::Text("GPU memory %.2f MB, peak %.2f MB", memory.Bytes / MEGABYTE, memory.Peak / MEGABYTE);
+    ImGui::Text("Idle frames skipped %llu", static_cast<unsigned long long>(m_SkippedFrames));
+    ImGui::Text("UI frames replayed %llu", static_cast<unsigned long long>(m_UICache.Replayed()));
+    if (m_Capture.Recording()) {
+        FrameCapture::Statistics capture = m_Capture.Stats();
+        ImGui::Text("Recording %llu written, %llu dropped", static_cast<unsigned long long>(capture.Written),
+                    static_cast<unsigned long long>(capture.DroppedGpu + capture.DroppedWriter));
+    }
+
+    ImGui::End();
 }
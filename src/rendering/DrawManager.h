@@ -2,7 +2,17 @@
 #define DrawManager_h
 
 #include "ShaderProgram.h"
+#include "ShaderVariants.h"
 #include "Cubemap.h"
+#include "BoundingVolumeHierarchy.h"
+#include "FrameRingBuffer.h"
+#include "Framebuffer.h"
+#include "DynamicResolution.h"
+#include "FrameCapture.h"
+#include "GPUTimers.h"
+#include "LightClusters.h"
+#include "UICache.h"
+#include "../utilities/ThreadPool.h"
 
 #pragma warning(push, 0)
 #include "../dependencies/imgui/imconfig.h"
@@ -15,6 +25,7 @@
 
 #include <vector>
 #include <array>
+#include <cstdint>
 #include <assert.h>
 #include <memory>
 
@@ -27,6 +38,18 @@ class ILightSource;
 
 class DrawManager {
 public:
+    // How overdraw of opaque drawables is kept down
+    enum class DepthStrategy {
+        NONE,               // Registration order
+        FRONT_TO_BACK,      // Sorted by view depth, hidden fragments mostly fail depth test before shading
+        PREPASS             // Depth only pass first, shading pass then runs once per pixel with GL_EQUAL
+    };
+
+    struct CullingStatistics {
+        std::size_t Visible{ 0 };
+        std::size_t Culled{ 0 };
+    };
+
     DrawManager() = default;
 
     void Initialize();
@@ -37,6 +60,18 @@ public:
     void Skybox(const std::string& right, const std::string& left, const std::string& top, const std::string& bottom, const std::string& back, const std::string& front);
     void Background(const glm::vec3& background);
 
+    DepthStrategy Depth() const { return m_Depth; }
+    void Depth(DepthStrategy strategy);
+
+    // Draws the scene at resolution scaled between bounds so GPU keeps target frame rate,
+    // then stretches it over the window, GUI stays at native resolution
+    void ResolutionScaling(float min_scale, float max_scale, float target_frame_rate);
+    float ResolutionScale() const { return m_Resolution != nullptr ? m_Resolution->Scale() : 1.0f; }
+
+    // Draws into offscreen framebuffer instead of window, used without default framebuffer
+    void Offscreen(unsigned int width, unsigned int height);
+    const Framebuffer* Offscreen() const { return m_Offscreen.get(); }
+
     void RegisterDrawCall(Drawable* component);
     void UnregisterDrawCall(Drawable* component);
 
@@ -46,19 +81,131 @@ public:
     void RegisterLightSource(ILightSource* light_source);
     void UnregisterLightSource(ILightSource* light_source);
 
-    void CallDraws() const;
-    void NetworkCallDraws(DrawingSnapshot *drawing_snapshot) const;
+    // Return false when nothing changed since the last frame and drawing was skipped
+    bool CallDraws();
+    bool NetworkCallDraws(DrawingSnapshot *drawing_snapshot);
+
+    // Forces next frame to be drawn
+    void Invalidate() { m_Dirty = true; }
+    std::uint64_t SkippedFrames() const { return m_SkippedFrames; }
+
+    // GPU time of rendering passes, averaged over last frames
+    GPUTimers::Timing PassTiming(GPUTimers::Pass pass) const { return m_Timers.Statistics(pass); }
+    // Statistics panel drawn over the scene
+    bool ShowStatistics() const { return m_ShowStatistics; }
+    void ShowStatistics(bool show);
+    // GPU memory panel, accounts of g_GLResources per kind and owner
+    bool ShowMemory() const { return m_ShowMemory; }
+    void ShowMemory(bool show);
+    // Boxes of visible drawables drawn by debug draw
+    bool ShowBounds() const { return m_ShowBounds; }
+    void ShowBounds(bool show);
+
+    // Recording and screenshots of drawn frames, recording draws every frame
+    FrameCapture& Capture() { return m_Capture; }
+
+    // Counts of the last drawn frame
+    const CullingStatistics& Culling() const { return m_Culling; }
 
 private:
+    // Everything needed to submit one drawable, recorded by worker threads
+    struct DrawPacket {
+        Drawable* ToDraw{ nullptr };
+        ShaderProgram::Type Shader{ ShaderProgram::Type::PURE_COLOR };
+        glm::mat4 Model{ 1.0f };
+        AABB Bounds;
+        GLintptr ObjectOffset{ 0 };    // Object block in m_FrameData
+        bool HasBounds{ false };
+        bool Visible{ true };
+        float ScreenSize{ 1.0f };    // Fraction of viewport height, set for visible packets with bounds
+        float Depth{ 0.0f };         // View depth of bounds center, set for visible packets with bounds
+    };
+
+    // Mirrors std140 layout of Frame uniform block
+    struct FrameBlock {
+        glm::mat4 Pv;
+        glm::mat4 SkyboxPv;
+        glm::vec4 ViewPos;
+    };
+
+    static constexpr std::size_t PARALLEL_PREPARE_THRESHOLD = 256;
+    static constexpr GLsizeiptr FRAME_DATA_SIZE = 64 * 1024;
+    static constexpr float MEGABYTE = 1024.0f * 1024.0f;
+
+    bool Dirty() const;
+    void PrepareDraws(const DrawingSnapshot* drawing_snapshot);
+    void Cull(const glm::mat4& pv);
+    // Visible packets in submission order of the depth strategy
+    void OrderDraws();
+    // Projected height of sphere as fraction of viewport height
+    static float ScreenSize(const glm::mat4& pv, const BoundingSphere& sphere);
+    // Picks size of the scene for this frame from timings of the frames collected since the last one
+    void ScaleResolution();
+    // Counts lights of the frame for variant defines and collects range limited ones into clusters of the view
+    void GatherLights(const glm::mat4& view, const glm::mat4& projection);
+    // Compiles variants needed by visible packets under lights of the frame before any is drawn
+    void PrewarmVariants();
+    // Variant for scene lights and drawable maps if type has variants, the only program of type otherwise
+    const ShaderProgram& Program(const DrawPacket& packet);
+    void SubmitDraws(const glm::mat4& pv, const glm::mat4& skybox_pv, const glm::vec3& view_pos);
+    // True if ImGui frame has to be built, cached draw data is replayed otherwise
+    bool UIChanged() const;
+    void DrawRetainedWidgets() const;
+    void DrawStatistics() const;
+    void DrawMemory() const;
+
     glm::vec3 m_Background{ 0.0f };
     std::unique_ptr<Cubemap> m_Skybox{ nullptr };
+    std::unique_ptr<Framebuffer> m_Offscreen{ nullptr };
+
+    // Scene is drawn into m_SceneTarget when its size differs from the window
+    std::unique_ptr<DynamicResolution> m_Resolution{ nullptr };
+    std::unique_ptr<Framebuffer> m_SceneTarget{ nullptr };
+    std::uint64_t m_ScaledFrames{ 0 };
+    unsigned int m_SceneWidth{ 0 };
+    unsigned int m_SceneHeight{ 0 };
 
     Camera* m_Camera{ nullptr };
     std::vector<Drawable*> m_Drawables;
     std::vector<IWidget*> m_Widgets;
     std::vector<ILightSource*> m_LightSources;
+    LightClusters m_LightClusters;
+    ShaderVariants::Defines m_LightDefines;
+    // Lights over the limits of light receiving programs are ignored, reported when their count changes
+    unsigned int m_IgnoredLights{ 0 };
+
+    // Parallel to m_Drawables, proxy is NULL_NODE for drawables without bounds
+    BoundingVolumeHierarchy m_BoundingVolumes;
+    std::vector<int> m_Proxies;
+    CullingStatistics m_Culling;
+
+    ThreadPool m_Workers;
+    std::vector<std::vector<DrawPacket>> m_PacketBuffers;
+    std::vector<DrawPacket> m_Packets;
+    std::vector<std::size_t> m_DrawOrder;
+    DepthStrategy m_Depth{ DepthStrategy::FRONT_TO_BACK };
+
+    FrameRingBuffer m_FrameData;
+
+    // Idle mode, frame is drawn only if its inputs differ from the last drawn one
+    bool m_Dirty{ true };
+    unsigned int m_DrawnWidth{ 0 };
+    unsigned int m_DrawnHeight{ 0 };
+    DrawingSnapshot m_DrawnSnapshot{};
+    glm::mat4 m_DrawnPv{ 0.0f };
+    std::vector<glm::mat4> m_DrawnModels;
+    std::uint64_t m_SkippedFrames{ 0 };
+
+    GPUTimers m_Timers;
+    UICache m_UICache;
+    FrameCapture m_Capture;
+    bool m_ShowStatistics{ false };
+    bool m_ShowMemory{ false };
+    bool m_ShowBounds{ false };
 
     std::array<ShaderProgram, static_cast<size_t>(ShaderProgram::Type::COUNT)> m_ShaderPrograms;
+    // Types specialized by defines, nullptr for the rest
+    std::array<std::unique_ptr<ShaderVariants>, static_cast<size_t>(ShaderProgram::Type::COUNT)> m_Variants;
 };
 
 #endif
@@ -3,3 +3,23 @@
 Drawable::Drawable(ShaderProgram::Type shader_type)
     : m_ShaderType(shader_type) {
 }
+
+bool Drawable::WorldBounds(const glm::mat4& local_to_world, AABB* bounds) const {
+    AABB local;
+    if (!LocalBounds(&local) || local.Empty()) {
+        return false;
+    }
+
+    *bounds = local.Transformed(local_to_world);
+    return true;
+}
+
+bool Drawable::WorldBounds(const glm::mat4& local_to_world, BoundingSphere* sphere) const {
+    AABB world;
+    if (!WorldBounds(local_to_world, &world)) {
+        return false;
+    }
+
+    *sphere = world.Sphere();
+    return true;
+}
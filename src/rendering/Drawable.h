@@ -2,6 +2,8 @@
 #define Drawable_h
 
 #include "ShaderProgram.h"
+#include "ShaderVariants.h"
+#include "Bounds.h"
 
 class Drawable {
 public:
@@ -12,8 +14,25 @@ public:
     Drawable(Drawable&&) = delete;
     Drawable* operator=(Drawable&&) = delete;
 
+    // "model" uniform is set by DrawManager before the call
     virtual void Draw(const ShaderProgram &shader) const = 0;
-    virtual void NetworkDraw(const ShaderProgram &shader, glm::mat4 local_to_world) const = 0;
+
+    // Local to world matrix used when drawing without network snapshot
+    virtual glm::mat4 Model() const { return glm::mat4(1.0f); }
+    // Local to world matrix used when drawing network snapshot, only drawables the server moves take its matrix
+    virtual glm::mat4 NetworkModel(const glm::mat4& local_to_world) const { (void)local_to_world; return Model(); }
+
+    // Bounds in object space, drawables without bounds are never culled
+    virtual bool LocalBounds(AABB* bounds) const { (void)bounds; return false; }
+    bool WorldBounds(const glm::mat4& local_to_world, AABB* bounds) const;
+    bool WorldBounds(const glm::mat4& local_to_world, BoundingSphere* sphere) const;
+
+    // Called before drawing with height of projected bounds as fraction of viewport height,
+    // drawables with levels of detail pick theirs here
+    virtual void ScreenSize(float fraction) { (void)fraction; }
+
+    // ShaderVariants::Map bits of material maps drawable binds, select variant of programs with variants
+    virtual unsigned int MaterialMaps() const { return ShaderVariants::NO_MAPS; }
 
     ShaderProgram::Type ShaderType() const { return m_ShaderType; }
     void ShaderType(ShaderProgram::Type type) { m_ShaderType = type; }
@@ -22,4 +41,4 @@ protected:
     ShaderProgram::Type m_ShaderType;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,47 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+DynamicResolution::DynamicResolution(float min_scale, float max_scale, float target_frame_rate)
+    : m_MinScale(std::clamp(min_scale, 0.1f, 1.0f))
+    , m_MaxScale(std::clamp(max_scale, m_MinScale, 1.0f))
+    , m_TargetFrameRate(std::max(target_frame_rate, 1.0f))
+    , m_Scale(m_MaxScale) {
+}
+
+void DynamicResolution::Update(float scene_time, float fixed_time) {
+    // Results of frames drawn before the change tell nothing about current scale
+    m_FramesSinceChange++;
+    if (m_FramesSinceChange <= GPUTimers::LATENCY) {
+        return;
+    }
+
+    if (!m_Measured) {
+        m_SceneTime = scene_time;
+        m_FixedTime = fixed_time;
+        m_Measured = true;
+    } else {
+        m_SceneTime += (scene_time - m_SceneTime) * SMOOTHING;
+        m_FixedTime += (fixed_time - m_FixedTime) * SMOOTHING;
+    }
+
+    if (m_FramesSinceChange < ADJUST_INTERVAL || m_SceneTime <= 0.0f) {
+        return;
+    }
+
+    float budget = std::max(1000.0f / m_TargetFrameRate * HEADROOM - m_FixedTime, 0.0f);
+    float scale = m_Scale * std::sqrt(budget / m_SceneTime);
+    scale = std::clamp(scale, m_Scale * (1.0f - MAX_STEP), m_Scale * (1.0f + MAX_STEP));
+    scale = std::clamp(scale, m_MinScale, m_MaxScale);
+
+    // Bounds are always reachable, small steps in between are not worth the change
+    bool bound = scale == m_MinScale || scale == m_MaxScale;
+    if (scale == m_Scale || (!bound && std::abs(scale - m_Scale) < MIN_STEP)) {
+        return;
+    }
+
+    m_Scale = scale;
+    m_Measured = false;
+    m_FramesSinceChange = 0;
+}
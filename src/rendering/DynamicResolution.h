@@ -0,0 +1,50 @@
+#ifndef DynamicResolution_h
+#define DynamicResolution_h
+
+#include "GPUTimers.h"
+
+/**
+ * Dynamic resolution
+ *
+ * Picks resolution scale of the 3D scene from measured GPU time, so that
+ * frame fits the budget of target frame rate. Cost of the scene is taken
+ * as proportional to its pixel count, scale therefore moves by square root
+ * of scene budget over smoothed scene time. Timer results arrive LATENCY
+ * frames late, so samples of frames drawn before a change are skipped,
+ * scale is adjusted at most every ADJUST_INTERVAL frames and changes below
+ * MIN_STEP are ignored, which keeps it from oscillating.
+ */
+class DynamicResolution {
+public:
+    // Share of frame budget GPU may spend, rest is left for scheduling noise
+    static constexpr float HEADROOM = 0.85f;
+    static constexpr float SMOOTHING = 0.25f;
+    static constexpr unsigned int ADJUST_INTERVAL = GPUTimers::LATENCY * 2;
+    static constexpr float MIN_STEP = 0.05f;
+    // Largest change of scale in one adjustment, relative to current scale
+    static constexpr float MAX_STEP = 0.25f;
+
+    DynamicResolution(float min_scale, float max_scale, float target_frame_rate);
+
+    // Milliseconds of a frame spent in passes drawn at scaled resolution and in the rest
+    void Update(float scene_time, float fixed_time);
+
+    float Scale() const { return m_Scale; }
+    float MinScale() const { return m_MinScale; }
+    float MaxScale() const { return m_MaxScale; }
+    float TargetFrameRate() const { return m_TargetFrameRate; }
+
+private:
+    float m_MinScale;
+    float m_MaxScale;
+    float m_TargetFrameRate;
+    float m_Scale;
+
+    // Smoothed times of frames drawn at current scale
+    float m_SceneTime{ 0.0f };
+    float m_FixedTime{ 0.0f };
+    bool m_Measured{ false };
+    unsigned int m_FramesSinceChange{ 0 };
+};
+
+#endif
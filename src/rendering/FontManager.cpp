@@ -0,0 +1,240 @@
+#include "FontManager.h"
+
+#include "GLResources.h"
+#include "../utilities/Hash.h"
+
+#pragma warning(push, 0)
+#include "../dependencies/imgui/imgui_impl_opengl3.h"
+#pragma warning(pop)
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+ImFont* FontManager::Default() {
+    std::uint64_t key = Fnv1a("<default>");
+    auto font = m_Fonts.find(key);
+    if (font != m_Fonts.end()) {
+        return font->second;
+    }
+
+    ImFont* added = ImGui::GetIO().Fonts->AddFontDefault();
+    m_Fonts.emplace(key, added);
+    m_Keys.push_back(key);
+    m_Paths.emplace_back();
+    m_Dirty = true;
+
+    return added;
+}
+
+ImFont* FontManager::Font(const std::string& path, float size, const ImWchar* ranges) {
+    std::uint64_t key = Fnv1a(path);
+    key = Fnv1a(&size, sizeof(size), key);
+    // Ranges are pairs of first and last code point terminated by zero
+    for (const ImWchar* range = ranges; range != nullptr && *range != 0; range++) {
+        key = Fnv1a(range, sizeof(ImWchar), key);
+    }
+
+    auto font = m_Fonts.find(key);
+    if (font != m_Fonts.end()) {
+        return font->second;
+    }
+
+    ImFont* added = ImGui::GetIO().Fonts->AddFontFromFileTTF(path.c_str(), size, nullptr, ranges);
+    m_Fonts.emplace(key, added);
+    m_Keys.push_back(key);
+    m_Paths.push_back(path);
+    m_Dirty = true;
+
+    return added;
+}
+
+void FontManager::Bake() {
+    if (!m_Dirty) {
+        return;
+    }
+
+    std::uint64_t key = Key();
+    m_Cached = Load(key);
+    if (!m_Cached) {
+        Build();
+        Store(key);
+    }
+
+    m_Baked = true;
+    m_Dirty = false;
+    m_Generation++;
+
+    // Backend uploads atlas as RGBA32
+    const ImFontAtlas* atlas = ImGui::GetIO().Fonts;
+    std::size_t atlas_bytes = static_cast<std::size_t>(atlas->TexWidth) * atlas->TexHeight * 4;
+    g_GLResources.Account(GLResources::Kind::TEXTURE, GLResources::Owner::FONTS, m_AtlasBytes, atlas_bytes);
+    m_AtlasBytes = atlas_bytes;
+}
+
+void FontManager::Update() {
+    if (!m_Baked || !m_Dirty) {
+        return;
+    }
+
+    Bake();
+
+    // Backend uploaded old atlas already, if not it uploads the new one with its first frame
+    ImFontAtlas* atlas = ImGui::GetIO().Fonts;
+    if (atlas->TexID != 0) {
+        ImGui_ImplOpenGL3_DestroyFontsTexture();
+        ImGui_ImplOpenGL3_CreateFontsTexture();
+    }
+}
+
+std::uint64_t FontManager::Key() const {
+    const ImFontAtlas* atlas = ImGui::GetIO().Fonts;
+
+    // Stored glyphs are raw structures, so layout of the library has to match
+    std::uint64_t hash = Fnv1a(IMGUI_VERSION);
+    std::uint64_t glyph_size = sizeof(ImFontGlyph);
+    hash = Fnv1a(&glyph_size, sizeof(glyph_size), hash);
+    hash = Fnv1a(&atlas->Flags, sizeof(atlas->Flags), hash);
+    hash = Fnv1a(&atlas->TexDesiredWidth, sizeof(atlas->TexDesiredWidth), hash);
+    hash = Fnv1a(&atlas->TexGlyphPadding, sizeof(atlas->TexGlyphPadding), hash);
+
+    for (std::size_t i = 0; i < m_Keys.size(); i++) {
+        hash = Fnv1a(&m_Keys[i], sizeof(m_Keys[i]), hash);
+        if (m_Paths[i].empty()) {
+            continue;
+        }
+
+        std::error_code error;
+        std::uint64_t size = std::filesystem::file_size(m_Paths[i], error);
+        std::int64_t time = std::filesystem::last_write_time(m_Paths[i], error).time_since_epoch().count();
+        hash = Fnv1a(&size, sizeof(size), hash);
+        hash = Fnv1a(&time, sizeof(time), hash);
+    }
+
+    return hash;
+}
+
+std::string FontManager::Path(std::uint64_t key) const {
+    return std::string(DIRECTORY) + "/" + HashToHex(key) + ".atlas";
+}
+
+void FontManager::Build() {
+    ImFontAtlas* atlas = ImGui::GetIO().Fonts;
+    atlas->ClearTexData();
+    atlas->Build();
+}
+
+bool FontManager::Load(std::uint64_t key) {
+    std::ifstream file(Path(key), std::ios::binary);
+    std::error_code error;
+    std::uint64_t size = std::filesystem::file_size(Path(key), error);
+    if (!file || error) {
+        return false;
+    }
+
+    ImFontAtlas* atlas = ImGui::GetIO().Fonts;
+
+    Header header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(Header));
+    if (!file || header.Magic != MAGIC || header.Version != VERSION || header.Fonts != static_cast<std::uint32_t>(atlas->Fonts.Size)
+        || header.Width <= 0 || header.Height <= 0) {
+        return false;
+    }
+
+    ImVec2 uv_scale;
+    ImVec2 uv_white_pixel;
+    ImVec4 uv_lines[IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1];
+    file.read(reinterpret_cast<char*>(&uv_scale), sizeof(uv_scale));
+    file.read(reinterpret_cast<char*>(&uv_white_pixel), sizeof(uv_white_pixel));
+    file.read(reinterpret_cast<char*>(uv_lines), sizeof(uv_lines));
+
+    std::vector<FontHeader> font_headers(header.Fonts);
+    std::vector<std::vector<ImFontGlyph>> glyphs(header.Fonts);
+    for (std::uint32_t i = 0; i < header.Fonts && file; i++) {
+        file.read(reinterpret_cast<char*>(&font_headers[i]), sizeof(FontHeader));
+        // Truncated or corrupt file is a miss, not an allocation of whatever the count says
+        if (!file || font_headers[i].Glyphs > (size - static_cast<std::uint64_t>(file.tellg())) / sizeof(ImFontGlyph)) {
+            return false;
+        }
+        glyphs[i].resize(font_headers[i].Glyphs);
+        file.read(reinterpret_cast<char*>(glyphs[i].data()), glyphs[i].size() * sizeof(ImFontGlyph));
+    }
+
+    std::size_t pixels_size = static_cast<std::size_t>(header.Width) * header.Height;
+    if (!file || pixels_size > size - static_cast<std::uint64_t>(file.tellg())) {
+        return false;
+    }
+    unsigned char* pixels = static_cast<unsigned char*>(IM_ALLOC(pixels_size));
+    file.read(reinterpret_cast<char*>(pixels), pixels_size);
+    if (!file) {
+        IM_FREE(pixels);
+        return false;
+    }
+
+    // Same state ImFontAtlas::Build() leaves behind, without rasterizing anything. Custom
+    // rectangles are not restored, they hold only software mouse cursor which is not used
+    atlas->ClearTexData();
+    atlas->TexPixelsAlpha8 = pixels;
+    atlas->TexWidth = header.Width;
+    atlas->TexHeight = header.Height;
+    atlas->TexUvScale = uv_scale;
+    atlas->TexUvWhitePixel = uv_white_pixel;
+    std::memcpy(atlas->TexUvLines, uv_lines, sizeof(uv_lines));
+
+    for (ImFontConfig& config : atlas->ConfigData) {
+        ImFont* font = config.DstFont;
+        if (!config.MergeMode) {
+            font->ConfigData = &config;
+            font->ConfigDataCount = 0;
+            font->ContainerAtlas = atlas;
+        }
+        font->ConfigDataCount++;
+    }
+
+    for (int i = 0; i < atlas->Fonts.Size; i++) {
+        ImFont* font = atlas->Fonts[i];
+        font->FontSize = font_headers[i].FontSize;
+        font->Ascent = font_headers[i].Ascent;
+        font->Descent = font_headers[i].Descent;
+
+        font->Glyphs.resize(static_cast<int>(glyphs[i].size()));
+        if (!glyphs[i].empty()) {
+            std::memcpy(font->Glyphs.Data, glyphs[i].data(), glyphs[i].size() * sizeof(ImFontGlyph));
+        }
+        font->BuildLookupTable();
+    }
+    atlas->TexReady = true;
+
+    return true;
+}
+
+void FontManager::Store(std::uint64_t key) const {
+    const ImFontAtlas* atlas = ImGui::GetIO().Fonts;
+    if (atlas->TexPixelsAlpha8 == nullptr) {
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(DIRECTORY, error);
+
+    std::ofstream file(Path(key), std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cout << "Font atlas failed to save at path: " << Path(key) << '\n';
+        return;
+    }
+
+    Header header{ MAGIC, VERSION, atlas->TexWidth, atlas->TexHeight, static_cast<std::uint32_t>(atlas->Fonts.Size) };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    file.write(reinterpret_cast<const char*>(&atlas->TexUvScale), sizeof(atlas->TexUvScale));
+    file.write(reinterpret_cast<const char*>(&atlas->TexUvWhitePixel), sizeof(atlas->TexUvWhitePixel));
+    file.write(reinterpret_cast<const char*>(atlas->TexUvLines), sizeof(atlas->TexUvLines));
+
+    for (const ImFont* font : atlas->Fonts) {
+        FontHeader font_header{ font->FontSize, font->Ascent, font->Descent, static_cast<std::uint32_t>(font->Glyphs.Size) };
+        file.write(reinterpret_cast<const char*>(&font_header), sizeof(FontHeader));
+        file.write(reinterpret_cast<const char*>(font->Glyphs.Data), font->Glyphs.Size * sizeof(ImFontGlyph));
+    }
+
+    file.write(reinterpret_cast<const char*>(atlas->TexPixelsAlpha8), static_cast<std::size_t>(atlas->TexWidth) * atlas->TexHeight);
+}
@@ -0,0 +1,83 @@
+#ifndef FontManager_h
+#define FontManager_h
+
+#pragma warning(push, 0)
+#include <imgui.h>
+#pragma warning(pop)
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Font manager
+ *
+ * Owns fonts of Dear ImGui atlas. Requesting font with the same path, size
+ * and glyph ranges twice returns the same ImFont, new fonts are only added
+ * to the atlas and rasterized together by Bake() once the scene is created.
+ * Baked atlas (pixels and glyph metrics) is stored in cache keyed by the
+ * list of fonts and their files, so following launches skip rasterization.
+ * Font requested after baking makes Update() rebuild the atlas outside of
+ * ImGui frame; returned ImFont pointers stay valid across rebuilds.
+ */
+class FontManager {
+public:
+    static constexpr const char* DIRECTORY = "cache/fonts";
+
+    FontManager() = default;
+
+    // Dear ImGui context has to exist
+    ImFont* Default();
+    ImFont* Font(const std::string& path, float size, const ImWchar* ranges = nullptr);
+
+    // Rasterizes atlas or loads it from cache, call after every font of the scene is requested
+    void Bake();
+    // Rebuilds atlas if font was added after baking, has to be called before ImGui frame starts
+    void Update();
+
+    std::size_t Fonts() const { return m_Fonts.size(); }
+    // Changes with every bake, glyph coordinates taken from older atlas are stale
+    std::uint64_t Generation() const { return m_Generation; }
+    bool Cached() const { return m_Cached; }
+
+private:
+    static constexpr std::uint32_t MAGIC = 0x4C544146;    // "FATL"
+    static constexpr std::uint32_t VERSION = 1;
+
+    struct Header {
+        std::uint32_t Magic;
+        std::uint32_t Version;
+        std::int32_t Width;
+        std::int32_t Height;
+        std::uint32_t Fonts;
+    };
+
+    struct FontHeader {
+        float FontSize;
+        float Ascent;
+        float Descent;
+        std::uint32_t Glyphs;
+    };
+
+    std::uint64_t Key() const;
+    std::string Path(std::uint64_t key) const;
+    void Build();
+    bool Load(std::uint64_t key);
+    void Store(std::uint64_t key) const;
+
+    std::unordered_map<std::uint64_t, ImFont*> m_Fonts;
+    // Keys and files in the order fonts were added to atlas
+    std::vector<std::uint64_t> m_Keys;
+    std::vector<std::string> m_Paths;
+    bool m_Baked{ false };
+    bool m_Dirty{ false };
+    bool m_Cached{ false };
+    std::uint64_t m_Generation{ 0 };
+    std::size_t m_AtlasBytes{ 0 };    // Atlas texture accounted to g_GLResources
+};
+
+extern FontManager g_FontManager;
+
+#endif
@@ -0,0 +1,387 @@
+#include "FrameCapture.h"
+
+#pragma warning(push, 0)
+#include <stb_image_write.h>
+#pragma warning(pop)
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+FrameCapture::~FrameCapture() {
+    if (m_Writer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stopping = true;
+        }
+        m_JobReady.notify_all();
+        m_Writer.join();
+    }
+
+    for (Slot& slot : m_Ring) {
+        if (slot.Fence != nullptr) {
+            glDeleteSync(slot.Fence);
+        }
+    }
+}
+
+void FrameCapture::StartRecording(const std::string& path, Format format, unsigned int frame_rate) {
+    // Frames of previous recording have to reach its stream first
+    if (m_StopPending) {
+        Collect(true);
+    }
+
+    // Wait timed out, frames still on GPU are dropped so they cannot end up in the new stream
+    if (m_StopPending) {
+        for (Slot& slot : m_Ring) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (slot.State == SlotState::READING && slot.Path.empty()) {
+                glDeleteSync(slot.Fence);
+                slot.Fence = nullptr;
+                slot.State = SlotState::FREE;
+                m_DroppedGpu++;
+            }
+        }
+
+        Job job;
+        job.Kind = Command::END;
+        Push(job);
+        m_StopPending = false;
+    }
+
+    Job job;
+    job.Kind = Command::BEGIN;
+    job.Path = path;
+    job.Encoding = format;
+    job.FrameRate = std::max(frame_rate, 1u);
+    Push(job);
+
+    m_Recording = true;
+    m_RecordedFrames = 0;
+}
+
+void FrameCapture::StopRecording() {
+    if (m_Recording) {
+        m_Recording = false;
+        m_StopPending = true;
+    }
+}
+
+void FrameCapture::Screenshot(const std::string& path) {
+    m_Screenshots.push_back(path);
+}
+
+void FrameCapture::Capture(GLuint framebuffer, unsigned int width, unsigned int height) {
+    Collect(false);
+
+    if ((!m_Recording && m_Screenshots.empty()) || width == 0 || height == 0) {
+        return;
+    }
+
+    Slot& slot = m_Ring[m_Next];
+    SlotState state;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        state = slot.State;
+    }
+    if (state != SlotState::FREE) {
+        // Screenshot waits for the next frame, recording just loses this one
+        if (m_Recording) {
+            (state == SlotState::READING ? m_DroppedGpu : m_DroppedWriter)++;
+        }
+        return;
+    }
+
+    slot.Width = width;
+    slot.Height = height;
+    if (!m_Screenshots.empty()) {
+        slot.Path = m_Screenshots.front();
+        m_Screenshots.pop_front();
+    } else {
+        slot.Path.clear();
+        slot.Index = m_RecordedFrames++;
+    }
+
+    if (!slot.Buffer) {
+        slot.Buffer = BufferHandle::Create(GLResources::Owner::STREAMING);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.Buffer.ID());
+    std::size_t size = static_cast<std::size_t>(width) * height * 4;
+    if (slot.Buffer.Bytes() != size) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_READ);
+        slot.Buffer.Bytes(size);
+    }
+
+    // Copy runs on GPU, call returns right away because destination is a buffer
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    if (framebuffer == 0) {
+        glReadBuffer(GL_BACK);
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.State = SlotState::READING;
+    m_Next = (m_Next + 1) % RING_SIZE;
+    m_Captured++;
+}
+
+void FrameCapture::Finish() {
+    StopRecording();
+    Collect(true);
+
+    // Writer drains the queue, buffers it released are unmapped below
+    if (m_Writer.joinable()) {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_JobDone.wait(lock, [this]() { return m_Jobs.empty() && !m_Busy; });
+    }
+    Collect(false);
+}
+
+FrameCapture::Statistics FrameCapture::Stats() const {
+    Statistics statistics;
+    statistics.Captured = m_Captured;
+    statistics.Written = m_Written;
+    statistics.DroppedGpu = m_DroppedGpu;
+    statistics.DroppedWriter = m_DroppedWriter + m_Mismatched;
+
+    return statistics;
+}
+
+void FrameCapture::Collect(bool blocking) {
+    // Oldest slot first, so frames reach the writer in order they were drawn
+    for (std::size_t i = 0; i < RING_SIZE; i++) {
+        Slot& slot = m_Ring[(m_Next + i) % RING_SIZE];
+
+        SlotState state;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            state = slot.State;
+        }
+
+        if (state == SlotState::WRITTEN) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.Buffer.ID());
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            slot.Pixels = nullptr;
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            slot.State = SlotState::FREE;
+        } else if (state == SlotState::READING) {
+            // Zero timeout only asks, flush makes sure the fence gets to GPU at all
+            GLuint64 timeout = blocking ? FINISH_TIMEOUT : 0;
+            GLenum result = glClientWaitSync(slot.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+            if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+                break;
+            }
+            glDeleteSync(slot.Fence);
+            slot.Fence = nullptr;
+
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.Buffer.ID());
+            slot.Pixels = static_cast<const unsigned char*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(slot.Buffer.Bytes()), GL_MAP_READ_BIT));
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            if (slot.Pixels == nullptr) {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                slot.State = SlotState::FREE;
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                slot.State = SlotState::WRITING;
+            }
+            Job job;
+            job.Kind = Command::FRAME;
+            job.Slot = (m_Next + i) % RING_SIZE;
+            Push(job);
+        }
+    }
+
+    // Stream closes after its last frame
+    bool reading = std::any_of(m_Ring.begin(), m_Ring.end(), [this](const Slot& slot) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return slot.State == SlotState::READING && slot.Path.empty();
+    });
+    if (m_StopPending && !reading) {
+        Job job;
+        job.Kind = Command::END;
+        Push(job);
+        m_StopPending = false;
+    }
+}
+
+void FrameCapture::Push(Job job) {
+    if (!m_Writer.joinable()) {
+        m_Writer = std::thread(&FrameCapture::WriterLoop, this);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Jobs.push_back(std::move(job));
+    }
+    m_JobReady.notify_one();
+}
+
+void FrameCapture::WriterLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_JobReady.wait(lock, [this]() { return m_Stopping || !m_Jobs.empty(); });
+            if (m_Jobs.empty()) {
+                break;
+            }
+
+            job = std::move(m_Jobs.front());
+            m_Jobs.pop_front();
+            m_Busy = true;
+        }
+
+        switch (job.Kind) {
+        case Command::BEGIN:
+            m_Stream.close();
+            m_Encoding = job.Encoding;
+            m_Path = job.Path;
+            m_FrameRate = job.FrameRate;
+            m_StreamWidth = m_StreamHeight = 0;
+            if (m_Encoding == Format::Y4M) {
+                m_Stream.open(m_Path, std::ios::binary | std::ios::trunc);
+                if (!m_Stream) {
+                    std::cout << "Recording failed to open at path: " << m_Path << '\n';
+                }
+            }
+            break;
+        case Command::FRAME:
+            WriteFrame(m_Ring[job.Slot]);
+            break;
+        case Command::END:
+            m_Stream.close();
+            m_Path.clear();
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (job.Kind == Command::FRAME) {
+                m_Ring[job.Slot].State = SlotState::WRITTEN;
+            }
+            m_Busy = false;
+        }
+        m_JobDone.notify_all();
+    }
+}
+
+void FrameCapture::WriteFrame(const Slot& slot) {
+    if (!slot.Path.empty()) {
+        if (WritePng(slot.Path, slot)) {
+            std::cout << "Screenshot saved at path: " << slot.Path << '\n';
+        }
+        return;
+    }
+
+    // Frames left over after the recording ended
+    if (m_Path.empty()) {
+        return;
+    }
+
+    if (m_Encoding == Format::Y4M) {
+        WriteY4M(slot);
+        return;
+    }
+
+    char number[16];
+    std::snprintf(number, sizeof(number), "%06llu", static_cast<unsigned long long>(slot.Index));
+    if (WritePng(m_Path + number + ".png", slot)) {
+        m_Written++;
+    }
+}
+
+void FrameCapture::WriteY4M(const Slot& slot) {
+    if (!m_Stream) {
+        return;
+    }
+
+    // Stream has one size, set by its first frame
+    if (m_StreamWidth == 0) {
+        m_StreamWidth = slot.Width;
+        m_StreamHeight = slot.Height;
+        m_Stream << "YUV4MPEG2 W" << m_StreamWidth << " H" << m_StreamHeight << " F" << m_FrameRate << ":1 Ip A1:1 C420jpeg\n";
+    }
+    if (slot.Width != m_StreamWidth || slot.Height != m_StreamHeight) {
+        m_Mismatched++;
+        return;
+    }
+
+    const unsigned int width = slot.Width;
+    const unsigned int height = slot.Height;
+    const unsigned int chroma_width = (width + 1) / 2;
+    const unsigned int chroma_height = (height + 1) / 2;
+    m_Scratch.resize(static_cast<std::size_t>(width) * height + 2 * static_cast<std::size_t>(chroma_width) * chroma_height);
+    unsigned char* luma = m_Scratch.data();
+    unsigned char* cb = luma + static_cast<std::size_t>(width) * height;
+    unsigned char* cr = cb + static_cast<std::size_t>(chroma_width) * chroma_height;
+
+    // Rows are read bottom first, planes are written top first
+    auto pixel = [&](unsigned int x, unsigned int y) {
+        return slot.Pixels + (static_cast<std::size_t>(height - 1 - y) * width + x) * 4;
+    };
+
+    // Full range BT.601 in 8 bit fixed point
+    for (unsigned int y = 0; y < height; y++) {
+        for (unsigned int x = 0; x < width; x++) {
+            const unsigned char* rgb = pixel(x, y);
+            luma[static_cast<std::size_t>(y) * width + x] = static_cast<unsigned char>((77 * rgb[0] + 150 * rgb[1] + 29 * rgb[2] + 128) >> 8);
+        }
+    }
+
+    for (unsigned int y = 0; y < chroma_height; y++) {
+        unsigned int y0 = 2 * y;
+        unsigned int y1 = std::min(2 * y + 1, height - 1);
+        for (unsigned int x = 0; x < chroma_width; x++) {
+            unsigned int x0 = 2 * x;
+            unsigned int x1 = std::min(2 * x + 1, width - 1);
+
+            int sum[3];
+            for (int c = 0; c < 3; c++) {
+                sum[c] = pixel(x0, y0)[c] + pixel(x1, y0)[c] + pixel(x0, y1)[c] + pixel(x1, y1)[c];
+            }
+
+            // Offset of 128 is added before the shift, which keeps the sums positive
+            int u = (-43 * sum[0] - 85 * sum[1] + 128 * sum[2] + 4 * 32896) >> 10;
+            int v = (128 * sum[0] - 107 * sum[1] - 21 * sum[2] + 4 * 32896) >> 10;
+            cb[static_cast<std::size_t>(y) * chroma_width + x] = static_cast<unsigned char>(std::min(u, 255));
+            cr[static_cast<std::size_t>(y) * chroma_width + x] = static_cast<unsigned char>(std::min(v, 255));
+        }
+    }
+
+    m_Stream << "FRAME\n";
+    m_Stream.write(reinterpret_cast<const char*>(m_Scratch.data()), static_cast<std::streamsize>(m_Scratch.size()));
+    if (m_Stream) {
+        m_Written++;
+    } else {
+        std::cout << "Recording failed to write at path: " << m_Path << '\n';
+    }
+}
+
+bool FrameCapture::WritePng(const std::string& path, const Slot& slot) {
+    // Top row first and without alpha, default framebuffer may hold anything there
+    const std::size_t row = static_cast<std::size_t>(slot.Width) * 3;
+    m_Scratch.resize(row * slot.Height);
+    for (unsigned int y = 0; y < slot.Height; y++) {
+        const unsigned char* source = slot.Pixels + static_cast<std::size_t>(slot.Height - 1 - y) * slot.Width * 4;
+        unsigned char* destination = m_Scratch.data() + y * row;
+        for (unsigned int x = 0; x < slot.Width; x++) {
+            destination[x * 3 + 0] = source[x * 4 + 0];
+            destination[x * 3 + 1] = source[x * 4 + 1];
+            destination[x * 3 + 2] = source[x * 4 + 2];
+        }
+    }
+
+    if (!stbi_write_png(path.c_str(), slot.Width, slot.Height, 3, m_Scratch.data(), static_cast<int>(row))) {
+        std::cout << "Frame failed to save at path: " << path << '\n';
+        return false;
+    }
+
+    return true;
+}
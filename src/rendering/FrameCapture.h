@@ -0,0 +1,153 @@
+#ifndef FrameCapture_h
+#define FrameCapture_h
+
+#include "GLResources.h"
+
+#pragma warning(push, 0)
+#include <glad/glad.h>
+#pragma warning(pop)
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Frame capture
+ *
+ * Records drawn frames and takes screenshots without stalling the GL
+ * thread. Frame is read into one of RING_SIZE pixel pack buffers and
+ * followed by a fence, buffer is mapped only once the fence signals on a
+ * later frame, and the mapped memory is handed straight to the writer
+ * thread, which converts and streams it to disk. Buffer is unmapped on GL
+ * thread after the writer is done with it. When the slot due for reuse is
+ * still being read back or written, the frame is dropped and counted, so
+ * slow disk never slows down drawing. Recording goes either into a single
+ * raw Y4M stream (4:2:0, full range BT.601) or into numbered PNG files.
+ */
+class FrameCapture {
+public:
+    enum class Format {
+        Y4M,
+        PNG
+    };
+
+    static constexpr std::size_t RING_SIZE = 4;
+    // Longest wait for read-back in flight when finishing, in nanoseconds
+    static constexpr GLuint64 FINISH_TIMEOUT = 1000000000;
+
+    struct Statistics {
+        std::uint64_t Captured{ 0 };        // Frames read back
+        std::uint64_t Written{ 0 };
+        std::uint64_t DroppedGpu{ 0 };      // Read-back still in flight when its buffer was due
+        std::uint64_t DroppedWriter{ 0 };   // Writer still busy with the buffer, or frame of other size in Y4M
+    };
+
+    FrameCapture() = default;
+    ~FrameCapture();
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+    FrameCapture(FrameCapture&&) = delete;
+    FrameCapture& operator=(FrameCapture&&) = delete;
+
+    // Y4M stream is written to path, PNG files get path as prefix of their numbers
+    void StartRecording(const std::string& path, Format format, unsigned int frame_rate);
+    void StopRecording();
+    bool Recording() const { return m_Recording; }
+
+    // Saves the next captured frame as PNG
+    void Screenshot(const std::string& path);
+    // Screenshots still waiting for a frame to be captured
+    bool Pending() const { return !m_Screenshots.empty(); }
+
+    // Call on GL thread after frame is drawn into framebuffer, before it is presented
+    void Capture(GLuint framebuffer, unsigned int width, unsigned int height);
+    // Maps read-backs that finished, in order, and unmaps buffers the writer is done with.
+    // Blocking waits for every read-back in flight. Call every frame, also when drawing is skipped
+    void Collect(bool blocking);
+    // Waits for frames in flight and writes them out, ends recording. Call with current context
+    void Finish();
+
+    Statistics Stats() const;
+
+private:
+    enum class SlotState {
+        FREE,
+        READING,    // Fence not signaled yet
+        WRITING,    // Mapped, owned by writer
+        WRITTEN     // Writer is done, waits for unmap
+    };
+
+    struct Slot {
+        BufferHandle Buffer;
+        GLsync Fence{ nullptr };
+        SlotState State{ SlotState::FREE };    // Guarded by mutex
+
+        const unsigned char* Pixels{ nullptr };    // RGBA, bottom row first
+        unsigned int Width{ 0 };
+        unsigned int Height{ 0 };
+        std::string Path;           // Screenshot path, empty for recorded frame
+        std::uint64_t Index{ 0 };   // Number of recorded frame
+    };
+
+    enum class Command {
+        BEGIN,
+        FRAME,
+        END
+    };
+
+    struct Job {
+        Command Kind{ Command::FRAME };
+        std::size_t Slot{ 0 };
+        std::string Path;
+        Format Encoding{ Format::Y4M };
+        unsigned int FrameRate{ 0 };
+    };
+
+    void Push(Job job);
+    void WriterLoop();
+
+    void WriteFrame(const Slot& slot);
+    void WriteY4M(const Slot& slot);
+    bool WritePng(const std::string& path, const Slot& slot);
+
+    // Following are touched only by GL thread
+    std::array<Slot, RING_SIZE> m_Ring;
+    std::size_t m_Next{ 0 };    // Oldest slot, reused next
+    bool m_Recording{ false };
+    // Recording stopped, stream is closed once its last frames leave the ring
+    bool m_StopPending{ false };
+    std::uint64_t m_RecordedFrames{ 0 };
+    std::deque<std::string> m_Screenshots;
+    std::uint64_t m_Captured{ 0 };
+    std::uint64_t m_DroppedGpu{ 0 };
+    std::uint64_t m_DroppedWriter{ 0 };
+
+    std::thread m_Writer;
+    std::mutex m_Mutex;
+    std::condition_variable m_JobReady;
+    std::condition_variable m_JobDone;
+    std::deque<Job> m_Jobs;
+    bool m_Stopping{ false };
+    bool m_Busy{ false };
+    std::atomic<std::uint64_t> m_Written{ 0 };
+    std::atomic<std::uint64_t> m_Mismatched{ 0 };
+
+    // Following are touched only by writer thread
+    Format m_Encoding{ Format::Y4M };
+    std::string m_Path;
+    unsigned int m_FrameRate{ 0 };
+    std::ofstream m_Stream;
+    unsigned int m_StreamWidth{ 0 };
+    unsigned int m_StreamHeight{ 0 };
+    std::vector<unsigned char> m_Scratch;
+};
+
+#endif
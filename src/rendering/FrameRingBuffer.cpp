@@ -0,0 +1,142 @@
+#include "FrameRingBuffer.h"
+
+#include "GLExtensions.h"
+
+#include <iostream>
+
+FrameRingBuffer::~FrameRingBuffer() {
+    Destroy();
+}
+
+void FrameRingBuffer::Initialize(GLenum target, GLsizeiptr region_size, GLResources::Owner owner) {
+    m_Target = target;
+    m_Owner = owner;
+    m_Persistent = g_GLExtensions.HasBufferStorage();
+
+    if (m_Target == GL_UNIFORM_BUFFER) {
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_Alignment);
+    }
+
+    Create(Aligned(region_size));
+}
+
+void FrameRingBuffer::BeginFrame(GLsizeiptr required_size) {
+    if (required_size > m_RegionSize) {
+        // Driver keeps old storage alive until GPU is done with it
+        GLsizeiptr region_size = m_RegionSize;
+        while (region_size < required_size) {
+            region_size *= 2;
+        }
+
+        Destroy();
+        Create(Aligned(region_size));
+    }
+
+    m_Region = (m_Region + 1) % FRAMES;
+    m_Head = 0;
+
+    glBindBuffer(m_Target, m_Buffer.ID());
+    if (m_Persistent) {
+        WaitForRegion(m_Region);
+    } else {
+        // Orphan previous storage instead of waiting for GPU to release it
+        glBufferData(m_Target, m_RegionSize, nullptr, GL_STREAM_DRAW);
+        m_Mapped = static_cast<unsigned char*>(glMapBufferRange(m_Target, 0, m_RegionSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+        if (m_Mapped == nullptr) {
+            std::cout << "ERROR::FRAME_RING_BUFFER::MAPPING_FAILED\n";
+        }
+    }
+}
+
+FrameRingBuffer::Allocation FrameRingBuffer::Allocate(GLsizeiptr size) {
+    Allocation allocation;
+    if (m_Mapped == nullptr || m_Head + size > m_RegionSize) {
+        return allocation;
+    }
+
+    GLintptr region_offset = m_Persistent ? static_cast<GLintptr>(m_Region) * m_RegionSize : 0;
+    allocation.Offset = region_offset + m_Head;
+    allocation.Data = m_Mapped + allocation.Offset;
+
+    m_Head += Aligned(size);
+
+    return allocation;
+}
+
+void FrameRingBuffer::Commit() {
+    if (m_Persistent) {
+        return;
+    }
+
+    glBindBuffer(m_Target, m_Buffer.ID());
+    glUnmapBuffer(m_Target);
+    m_Mapped = nullptr;
+}
+
+void FrameRingBuffer::EndFrame() {
+    if (!m_Persistent) {
+        return;
+    }
+
+    if (m_Fences[m_Region] != nullptr) {
+        glDeleteSync(m_Fences[m_Region]);
+    }
+    m_Fences[m_Region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void FrameRingBuffer::Create(GLsizeiptr region_size) {
+    m_RegionSize = region_size;
+    m_Region = 0;
+
+    m_Buffer = BufferHandle::Create(m_Owner);
+    glBindBuffer(m_Target, m_Buffer.ID());
+
+    if (m_Persistent) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLsizeiptr size = m_RegionSize * static_cast<GLsizeiptr>(FRAMES);
+
+        g_GLExtensions.BufferStorage(m_Target, size, nullptr, flags);
+        m_Mapped = static_cast<unsigned char*>(glMapBufferRange(m_Target, 0, size, flags));
+        if (m_Mapped == nullptr) {
+            std::cout << "ERROR::FRAME_RING_BUFFER::MAPPING_FAILED\n";
+        }
+    } else {
+        glBufferData(m_Target, m_RegionSize, nullptr, GL_STREAM_DRAW);
+    }
+
+    // Orphaned storage the driver still holds is not seen
+    m_Buffer.Bytes(static_cast<std::size_t>(m_Persistent ? m_RegionSize * static_cast<GLsizeiptr>(FRAMES) : m_RegionSize));
+}
+
+void FrameRingBuffer::Destroy() {
+    for (GLsync& fence : m_Fences) {
+        if (fence != nullptr) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    // Deleting buffer unmaps it too
+    m_Mapped = nullptr;
+    m_Buffer.Reset();
+}
+
+void FrameRingBuffer::WaitForRegion(std::size_t region) {
+    GLsync& fence = m_Fences[region];
+    if (fence == nullptr) {
+        return;
+    }
+
+    // Flush on first try only, later tries just keep waiting
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while (true) {
+        GLenum result = glClientWaitSync(fence, flags, 1000000);
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED) {
+            break;
+        }
+        flags = 0;
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
@@ -0,0 +1,78 @@
+#ifndef FrameRingBuffer_h
+#define FrameRingBuffer_h
+
+#pragma warning(push, 0)
+#include <glad/glad.h>
+#pragma warning(pop)
+
+#include "GLResources.h"
+
+#include <array>
+#include <cstddef>
+
+/**
+ * Frame ring buffer
+ *
+ * One buffer object streaming data that changes every frame. Buffer is split
+ * into regions, one per frame in flight, each guarded by fence placed after
+ * the frame's last draw. Writing into a region first waits for the GPU to
+ * finish the frame that used it last, so the driver never has to stall.
+ * With ARB_buffer_storage regions are persistently and coherently mapped,
+ * data is simply copied into mapped memory. Otherwise the buffer is orphaned
+ * and mapped every frame, and Commit() unmaps it before drawing.
+ */
+class FrameRingBuffer {
+public:
+    static constexpr std::size_t FRAMES = 3;
+
+    struct Allocation {
+        unsigned char* Data{ nullptr };
+        GLintptr Offset{ 0 };
+    };
+
+    FrameRingBuffer() = default;
+    ~FrameRingBuffer();
+    FrameRingBuffer(const FrameRingBuffer&) = delete;
+    FrameRingBuffer& operator=(const FrameRingBuffer&) = delete;
+    FrameRingBuffer(FrameRingBuffer&&) = delete;
+    FrameRingBuffer& operator=(FrameRingBuffer&&) = delete;
+
+    void Initialize(GLenum target, GLsizeiptr region_size, GLResources::Owner owner = GLResources::Owner::STREAMING);
+    // Has to be called with current context, buffers outliving the context release it early
+    void Destroy();
+
+    // Makes next region writable, grows regions that are smaller than required size
+    void BeginFrame(GLsizeiptr required_size);
+    // Returns nullptr data when region is full
+    Allocation Allocate(GLsizeiptr size);
+    // Makes written data visible to GPU, call before first draw using it
+    void Commit();
+    // Fences region, call after last draw using it
+    void EndFrame();
+
+    GLuint Buffer() const { return m_Buffer.ID(); }
+    GLint Alignment() const { return m_Alignment; }
+    bool Persistent() const { return m_Persistent; }
+
+    // Rounds size up to the offset alignment required by target
+    GLsizeiptr Aligned(GLsizeiptr size) const { return (size + m_Alignment - 1) / m_Alignment * m_Alignment; }
+
+private:
+    void Create(GLsizeiptr region_size);
+    void WaitForRegion(std::size_t region);
+
+    GLenum m_Target{ GL_UNIFORM_BUFFER };
+    BufferHandle m_Buffer;
+    GLint m_Alignment{ 1 };
+    bool m_Persistent{ false };
+    GLResources::Owner m_Owner{ GLResources::Owner::STREAMING };
+
+    GLsizeiptr m_RegionSize{ 0 };
+    std::size_t m_Region{ 0 };
+    GLsizeiptr m_Head{ 0 };
+
+    unsigned char* m_Mapped{ nullptr };
+    std::array<GLsync, FRAMES> m_Fences{};
+};
+
+#endif
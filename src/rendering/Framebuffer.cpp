@@ -0,0 +1,70 @@
+#include "Framebuffer.h"
+
+#include "GLResources.h"
+#include "GLState.h"
+
+#include <algorithm>
+#include <iostream>
+
+Framebuffer::Framebuffer(unsigned int width, unsigned int height)
+    : m_Width(width)
+    , m_Height(height) {
+    Create();
+}
+
+void Framebuffer::Bind() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer.ID());
+    glViewport(0, 0, m_Width, m_Height);
+}
+
+void Framebuffer::Bind(unsigned int width, unsigned int height) const {
+    glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer.ID());
+    glViewport(0, 0, std::min(width, m_Width), std::min(height, m_Height));
+}
+
+void Framebuffer::Resize(unsigned int width, unsigned int height) {
+    if (width == m_Width && height == m_Height) {
+        return;
+    }
+
+    m_Width = width;
+    m_Height = height;
+
+    // Handles release previous objects when they are replaced
+    Create();
+}
+
+void Framebuffer::ReadPixels(std::vector<unsigned char>* pixels) const {
+    pixels->resize(static_cast<std::size_t>(m_Width) * m_Height * 4);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_Framebuffer.ID());
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_Width, m_Height, GL_RGBA, GL_UNSIGNED_BYTE, pixels->data());
+}
+
+void Framebuffer::Create() {
+    m_Color = TextureHandle::Create(GLResources::Owner::RENDER_TARGETS);
+    g_GLState.BindTexture(GL_TEXTURE_2D, m_Color.ID());
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    m_Color.Bytes(static_cast<std::size_t>(m_Width) * m_Height * 4);
+
+    m_Depth = RenderbufferHandle::Create(GLResources::Owner::RENDER_TARGETS);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_Depth.ID());
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, m_Width, m_Height);
+    // 24 bit depth, which drivers store in 4 bytes
+    m_Depth.Bytes(static_cast<std::size_t>(m_Width) * m_Height * 4);
+
+    m_Framebuffer = FramebufferHandle::Create(GLResources::Owner::RENDER_TARGETS);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer.ID());
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_Color.ID(), 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_Depth.ID());
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "ERROR::FRAMEBUFFER::INCOMPLETE " << m_Width << 'x' << m_Height << '\n';
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
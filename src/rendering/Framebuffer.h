@@ -0,0 +1,52 @@
+#ifndef Framebuffer_h
+#define Framebuffer_h
+
+#include "GLResources.h"
+
+#pragma warning(push, 0)
+#include <glad/glad.h>
+#pragma warning(pop)
+
+#include <vector>
+
+/**
+ * Framebuffer
+ *
+ * Offscreen render target with RGBA8 color and 24 bit depth attachments.
+ * Used when there is no default framebuffer to draw into, e.g. headless
+ * context created without any surface, and for the scene drawn at scaled
+ * resolution.
+ */
+class Framebuffer {
+public:
+    Framebuffer(unsigned int width, unsigned int height);
+    ~Framebuffer() = default;
+    Framebuffer(const Framebuffer&) = delete;
+    Framebuffer& operator=(const Framebuffer&) = delete;
+    Framebuffer(Framebuffer&&) = delete;
+    Framebuffer& operator=(Framebuffer&&) = delete;
+
+    void Bind() const;
+    // Draws into bottom left corner of given size only
+    void Bind(unsigned int width, unsigned int height) const;
+    void Resize(unsigned int width, unsigned int height);
+
+    // Tightly packed RGBA rows, bottom row first
+    void ReadPixels(std::vector<unsigned char>* pixels) const;
+
+    GLuint ID() const { return m_Framebuffer.ID(); }
+    GLuint ColorTexture() const { return m_Color.ID(); }
+    unsigned int Width() const { return m_Width; }
+    unsigned int Height() const { return m_Height; }
+
+private:
+    void Create();
+
+    FramebufferHandle m_Framebuffer;
+    TextureHandle m_Color;
+    RenderbufferHandle m_Depth;
+    unsigned int m_Width;
+    unsigned int m_Height;
+};
+
+#endif
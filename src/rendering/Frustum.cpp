@@ -0,0 +1,88 @@
+#include "Frustum.h"
+
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
+
+Frustum::Frustum(const glm::mat4& pv) {
+    // Gribb-Hartmann plane extraction, glm matrices are column major
+    auto row = [&](int i) { return glm::vec4(pv[0][i], pv[1][i], pv[2][i], pv[3][i]); };
+
+    const glm::vec4 planes[PLANES] = {
+        row(3) + row(0),    // Left
+        row(3) - row(0),    // Right
+        row(3) + row(1),    // Bottom
+        row(3) - row(1),    // Top
+        row(3) + row(2),    // Near
+        row(3) - row(2)     // Far
+    };
+
+    for (int i = 0; i < PADDED_PLANES; i++) {
+        // Padding repeats the first plane, testing it twice does not change the result
+        glm::vec4 plane = planes[i < PLANES ? i : 0];
+        plane = plane / glm::length(glm::vec3(plane));
+
+        m_X[i] = plane.x;
+        m_Y[i] = plane.y;
+        m_Z[i] = plane.z;
+        m_W[i] = plane.w;
+    }
+}
+
+Frustum::EResult Frustum::Test(const AABB& box) const {
+    const glm::vec3 center = box.Center();
+    const glm::vec3 extents = box.Extents();
+
+#ifdef FRUSTUM_SSE
+    const __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+    const __m128 ex = _mm_set1_ps(extents.x), ey = _mm_set1_ps(extents.y), ez = _mm_set1_ps(extents.z);
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    int intersecting = 0;
+    for (int i = 0; i < PADDED_PLANES; i += 4) {
+        const __m128 px = _mm_load_ps(m_X + i), py = _mm_load_ps(m_Y + i), pz = _mm_load_ps(m_Z + i);
+
+        // Signed distance of the center and projected radius of the box for four planes
+        __m128 distance = _mm_add_ps(_mm_mul_ps(px, cx), _mm_add_ps(_mm_mul_ps(py, cy), _mm_mul_ps(pz, cz)));
+        distance = _mm_add_ps(distance, _mm_load_ps(m_W + i));
+        __m128 radius = _mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign_mask, px), ex),
+                                   _mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign_mask, py), ey),
+                                              _mm_mul_ps(_mm_andnot_ps(sign_mask, pz), ez)));
+
+        if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), zero)) != 0) {
+            return EResult::OUTSIDE;
+        }
+        intersecting |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(distance, radius), zero));
+    }
+
+    return intersecting != 0 ? EResult::INTERSECT : EResult::INSIDE;
+#else
+    bool intersecting = false;
+    for (int i = 0; i < PLANES; i++) {
+        float distance = m_X[i] * center.x + m_Y[i] * center.y + m_Z[i] * center.z + m_W[i];
+        float radius = std::fabs(m_X[i]) * extents.x + std::fabs(m_Y[i]) * extents.y + std::fabs(m_Z[i]) * extents.z;
+
+        if (distance + radius < 0.0f) {
+            return EResult::OUTSIDE;
+        }
+        intersecting = intersecting || distance - radius < 0.0f;
+    }
+
+    return intersecting ? EResult::INTERSECT : EResult::INSIDE;
+#endif
+}
+
+bool Frustum::Visible(const BoundingSphere& sphere) const {
+    for (int i = 0; i < PLANES; i++) {
+        float distance = m_X[i] * sphere.Center.x + m_Y[i] * sphere.Center.y + m_Z[i] * sphere.Center.z + m_W[i];
+        if (distance < -sphere.Radius) {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,43 @@
+#ifndef Frustum_h
+#define Frustum_h
+
+#include "Bounds.h"
+
+#pragma warning(push, 0)
+#include <glm/glm.hpp>
+#pragma warning(pop)
+
+/**
+ * View frustum
+ *
+ * Six planes extracted from projection * view matrix, pointing inwards.
+ * Planes are stored as structure of arrays padded to eight entries, so
+ * box test can check four planes at once with SSE. Without SSE the same
+ * layout is walked by a scalar loop.
+ */
+class Frustum {
+public:
+    enum class EResult {
+        OUTSIDE,
+        INTERSECT,
+        INSIDE
+    };
+
+    Frustum() = default;
+    explicit Frustum(const glm::mat4& pv);
+
+    EResult Test(const AABB& box) const;
+    bool Visible(const AABB& box) const { return Test(box) != EResult::OUTSIDE; }
+    bool Visible(const BoundingSphere& sphere) const;
+
+private:
+    static constexpr int PLANES = 6;
+    static constexpr int PADDED_PLANES = 8;
+
+    alignas(16) float m_X[PADDED_PLANES]{};
+    alignas(16) float m_Y[PADDED_PLANES]{};
+    alignas(16) float m_Z[PADDED_PLANES]{};
+    alignas(16) float m_W[PADDED_PLANES]{};
+};
+
+#endif
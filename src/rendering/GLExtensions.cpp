@@ -0,0 +1,50 @@
+#include "GLExtensions.h"
+
+#pragma warning(push, 0)
+#include <GLFW/glfw3.h>
+#pragma warning(pop)
+
+void GLExtensions::Load() {
+    glGetIntegerv(GL_MAJOR_VERSION, &m_Major);
+    glGetIntegerv(GL_MINOR_VERSION, &m_Minor);
+
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        m_Extensions.insert(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)));
+    }
+
+    if (Version(4, 4) || Supported("GL_ARB_buffer_storage")) {
+        BufferStorage = reinterpret_cast<BufferStorage_t>(glfwGetProcAddress("glBufferStorage"));
+    }
+
+    // Driver may support binaries but offer no format to store them in
+    GLint binary_formats = 0;
+    if (Version(4, 1) || Supported("GL_ARB_get_program_binary")) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binary_formats);
+    }
+    if (binary_formats > 0) {
+        GetProgramBinary = reinterpret_cast<GetProgramBinary_t>(glfwGetProcAddress("glGetProgramBinary"));
+        ProgramBinary = reinterpret_cast<ProgramBinary_t>(glfwGetProcAddress("glProgramBinary"));
+        ProgramParameteri = reinterpret_cast<ProgramParameteri_t>(glfwGetProcAddress("glProgramParameteri"));
+        if (ProgramBinary == nullptr || ProgramParameteri == nullptr) {
+            GetProgramBinary = nullptr;
+        }
+    }
+
+    if (Supported("GL_KHR_parallel_shader_compile")) {
+        MaxShaderCompilerThreads = reinterpret_cast<MaxShaderCompilerThreads_t>(glfwGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+    } else if (Supported("GL_ARB_parallel_shader_compile")) {
+        MaxShaderCompilerThreads = reinterpret_cast<MaxShaderCompilerThreads_t>(glfwGetProcAddress("glMaxShaderCompilerThreadsARB"));
+    }
+
+    m_TextureCompressionS3TC = Supported("GL_EXT_texture_compression_s3tc");
+}
+
+bool GLExtensions::Supported(const std::string& extension) const {
+    return m_Extensions.find(extension) != m_Extensions.end();
+}
+
+bool GLExtensions::Version(int major, int minor) const {
+    return m_Major > major || (m_Major == major && m_Minor >= minor);
+}
@@ -0,0 +1,80 @@
+#ifndef GLExtensions_h
+#define GLExtensions_h
+
+#pragma warning(push, 0)
+#include <glad/glad.h>
+#pragma warning(pop)
+
+#include <string>
+#include <unordered_set>
+
+// glad is generated for core 3.3, tokens of newer features are defined here
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_DYNAMIC_STORAGE_BIT
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#endif
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+/**
+ * Optional OpenGL features
+ *
+ * Renderer targets core 3.3, anything newer is used only when the driver
+ * exposes it either as core version or as extension. Entry points of such
+ * features are not loaded by glad, so they are fetched here and stay
+ * nullptr when not available. Load() has to be called with current context.
+ */
+class GLExtensions {
+public:
+    using BufferStorage_t = void (APIENTRYP)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+    using GetProgramBinary_t = void (APIENTRYP)(GLuint program, GLsizei buffer_size, GLsizei* length, GLenum* format, void* binary);
+    using ProgramBinary_t = void (APIENTRYP)(GLuint program, GLenum format, const void* binary, GLsizei length);
+    using ProgramParameteri_t = void (APIENTRYP)(GLuint program, GLenum name, GLint value);
+    using MaxShaderCompilerThreads_t = void (APIENTRYP)(GLuint count);
+
+    GLExtensions() = default;
+
+    void Load();
+
+    bool Supported(const std::string& extension) const;
+    bool Version(int major, int minor) const;
+
+    bool HasBufferStorage() const { return BufferStorage != nullptr; }
+    bool HasProgramBinary() const { return GetProgramBinary != nullptr; }
+    bool HasParallelShaderCompile() const { return MaxShaderCompilerThreads != nullptr; }
+    bool HasTextureCompressionS3TC() const { return m_TextureCompressionS3TC; }
+
+    BufferStorage_t BufferStorage{ nullptr };
+    GetProgramBinary_t GetProgramBinary{ nullptr };
+    ProgramBinary_t ProgramBinary{ nullptr };
+    ProgramParameteri_t ProgramParameteri{ nullptr };
+    MaxShaderCompilerThreads_t MaxShaderCompilerThreads{ nullptr };
+
+private:
+    std::unordered_set<std::string> m_Extensions;
+    int m_Major{ 0 };
+    int m_Minor{ 0 };
+    bool m_TextureCompressionS3TC{ false };
+};
+
+extern GLExtensions g_GLExtensions;
+
+#endif
@@ -0,0 +1,212 @@
+#include "GLResources.h"
+
+#include "GLState.h"
+
+#include <algorithm>
+#include <iomanip>
+
+const char* GLResources::Name(Kind kind) {
+    switch (kind) {
+    case Kind::BUFFER:
+        return "Buffers";
+    case Kind::VERTEX_ARRAY:
+        return "Vertex arrays";
+    case Kind::TEXTURE:
+        return "Textures";
+    case Kind::PROGRAM:
+        return "Programs";
+    case Kind::FRAMEBUFFER:
+        return "Framebuffers";
+    case Kind::RENDERBUFFER:
+        return "Renderbuffers";
+    case Kind::QUERY:
+        return "Queries";
+    default:
+        return "";
+    }
+}
+
+const char* GLResources::Name(Owner owner) {
+    switch (owner) {
+    case Owner::UNTAGGED:
+        return "Untagged";
+    case Owner::CUBIES:
+        return "Cubies";
+    case Owner::MESHES:
+        return "Meshes";
+    case Owner::TEXTURES:
+        return "Textures";
+    case Owner::SKYBOX:
+        return "Skybox";
+    case Owner::FONTS:
+        return "Fonts";
+    case Owner::SHADERS:
+        return "Shaders";
+    case Owner::RENDER_TARGETS:
+        return "Render targets";
+    case Owner::STREAMING:
+        return "Streaming";
+    case Owner::DEBUG:
+        return "Debug";
+    default:
+        return "";
+    }
+}
+
+GLuint GLResources::Create(Kind kind, Owner owner) {
+    GLuint id = 0;
+    switch (kind) {
+    case Kind::BUFFER:
+        glGenBuffers(1, &id);
+        break;
+    case Kind::VERTEX_ARRAY:
+        glGenVertexArrays(1, &id);
+        break;
+    case Kind::TEXTURE:
+        glGenTextures(1, &id);
+        break;
+    case Kind::PROGRAM:
+        id = glCreateProgram();
+        break;
+    case Kind::FRAMEBUFFER:
+        glGenFramebuffers(1, &id);
+        break;
+    case Kind::RENDERBUFFER:
+        glGenRenderbuffers(1, &id);
+        break;
+    case Kind::QUERY:
+        glGenQueries(1, &id);
+        break;
+    default:
+        break;
+    }
+
+    if (id != 0) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Kinds[kind].Live++;
+        m_Owners[static_cast<std::size_t>(owner)].Live++;
+        m_Total.Live++;
+    }
+
+    return id;
+}
+
+void GLResources::Release(Kind kind, Owner owner, GLuint id, std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Released[kind].push_back(id);
+
+    Usage& owner_usage = m_Owners[static_cast<std::size_t>(owner)];
+    m_Kinds[kind].Live--;
+    m_Kinds[kind].Bytes -= bytes;
+    owner_usage.Live--;
+    owner_usage.Bytes -= bytes;
+    m_Total.Live--;
+    m_Total.Bytes -= bytes;
+}
+
+void GLResources::Account(Kind kind, Owner owner, std::size_t old_bytes, std::size_t new_bytes) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Add(&m_Kinds[kind], new_bytes - old_bytes);
+    Add(&m_Owners[static_cast<std::size_t>(owner)], new_bytes - old_bytes);
+    Add(&m_Total, new_bytes - old_bytes);
+}
+
+void GLResources::Add(Usage* usage, std::size_t bytes) {
+    // Unsigned wrap around makes shrinking work too
+    usage->Bytes += bytes;
+    usage->Peak = std::max(usage->Peak, usage->Bytes);
+}
+
+void GLResources::Collect() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (int kind = 0; kind < Kind::COUNT; kind++) {
+            m_Deleting[kind].swap(m_Released[kind]);
+        }
+    }
+
+    for (int kind = 0; kind < Kind::COUNT; kind++) {
+        std::vector<GLuint>& names = m_Deleting[kind];
+        if (names.empty()) {
+            continue;
+        }
+
+        GLsizei count = static_cast<GLsizei>(names.size());
+        switch (kind) {
+        case Kind::BUFFER:
+            glDeleteBuffers(count, names.data());
+            break;
+        case Kind::VERTEX_ARRAY:
+            g_GLState.DeleteVertexArrays(count, names.data());
+            break;
+        case Kind::TEXTURE:
+            g_GLState.DeleteTextures(count, names.data());
+            break;
+        case Kind::PROGRAM:
+            // Programs have no batched delete
+            for (GLuint program : names) {
+                g_GLState.DeleteProgram(program);
+            }
+            break;
+        case Kind::FRAMEBUFFER:
+            glDeleteFramebuffers(count, names.data());
+            break;
+        case Kind::RENDERBUFFER:
+            glDeleteRenderbuffers(count, names.data());
+            break;
+        case Kind::QUERY:
+            glDeleteQueries(count, names.data());
+            break;
+        default:
+            break;
+        }
+
+        // Capacity is kept for the next frame
+        names.clear();
+    }
+}
+
+GLResources::Usage GLResources::Stats(Kind kind) const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Kinds[kind];
+}
+
+GLResources::Usage GLResources::Stats(Owner owner) const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Owners[static_cast<std::size_t>(owner)];
+}
+
+GLResources::Usage GLResources::Total() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Total;
+}
+
+std::size_t GLResources::Pending() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::size_t pending = 0;
+    for (const std::vector<GLuint>& names : m_Released) {
+        pending += names.size();
+    }
+
+    return pending;
+}
+
+void GLResources::Dump(std::ostream& stream) const {
+    auto row = [&stream](const char* name, const Usage& usage) {
+        stream << "  " << std::left << std::setw(16) << name << std::right
+               << std::setw(8) << usage.Live
+               << std::setw(14) << usage.Bytes
+               << std::setw(14) << usage.Peak << '\n';
+    };
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    stream << "GPU memory      objects         bytes          peak\n";
+    for (int kind = 0; kind < Kind::COUNT; kind++) {
+        row(Name(static_cast<Kind>(kind)), m_Kinds[kind]);
+    }
+    stream << "By owner\n";
+    for (std::size_t owner = 0; owner < m_Owners.size(); owner++) {
+        row(Name(static_cast<Owner>(owner)), m_Owners[owner]);
+    }
+    row("Total", m_Total);
+}
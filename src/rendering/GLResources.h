@@ -0,0 +1,185 @@
+#ifndef GLResources_h
+#define GLResources_h
+
+#pragma warning(push, 0)
+#include <glad/glad.h>
+#pragma warning(pop)
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+/**
+ * GL resources
+ *
+ * Creates GL objects for GLHandle and deletes them once they are released.
+ * Release only queues the name, so handle may be destroyed on any thread,
+ * even after the context is gone. Queued names are deleted in one batch
+ * per kind by Collect(), called on GL thread at the end of every frame.
+ * Names released after the last Collect() before the context is destroyed
+ * are never deleted, so owners have to go away before it.
+ *
+ * Also keeps GPU memory accounts. Every allocation of buffer or texture
+ * storage is reported with its kind and owner tag, either through handle
+ * or by Account() for objects whose owners manage their lifetime
+ * themselves. Bytes are the size of the data as specified, driver padding
+ * and copies kept by orphaning are not seen. High-water mark is kept for
+ * the total and for every owner.
+ */
+class GLResources {
+public:
+    enum Kind : int {
+        BUFFER = 0,
+        VERTEX_ARRAY,
+        TEXTURE,
+        PROGRAM,
+        FRAMEBUFFER,
+        RENDERBUFFER,
+        QUERY,
+
+        COUNT
+    };
+
+    enum class Owner : int {
+        UNTAGGED = 0,
+        CUBIES,
+        MESHES,
+        TEXTURES,           // Material maps of meshes
+        SKYBOX,
+        FONTS,              // Font atlas and text layouts
+        SHADERS,
+        RENDER_TARGETS,     // Offscreen and scaled scene framebuffers
+        STREAMING,          // Per-frame data, uploads and read-backs
+        DEBUG,              // Debug lines and GPU timers
+
+        COUNT
+    };
+
+    struct Usage {
+        std::size_t Live{ 0 };     // Objects held through handles
+        std::size_t Bytes{ 0 };
+        std::size_t Peak{ 0 };
+    };
+
+    static const char* Name(Kind kind);
+    static const char* Name(Owner owner);
+
+    GLResources() = default;
+    GLResources(const GLResources&) = delete;
+    GLResources& operator=(const GLResources&) = delete;
+    GLResources(GLResources&&) = delete;
+    GLResources& operator=(GLResources&&) = delete;
+
+    // Has to be called on GL thread
+    GLuint Create(Kind kind, Owner owner);
+    // Any thread, object is deleted by the next Collect()
+    void Release(Kind kind, Owner owner, GLuint id, std::size_t bytes);
+    // Any thread, storage of object changed its size
+    void Account(Kind kind, Owner owner, std::size_t old_bytes, std::size_t new_bytes);
+
+    // Deletes released objects, has to be called on GL thread
+    void Collect();
+
+    Usage Stats(Kind kind) const;
+    Usage Stats(Owner owner) const;
+    Usage Total() const;
+    std::size_t Pending() const;
+
+    // Table of totals, high-water marks and per-owner breakdown
+    void Dump(std::ostream& stream) const;
+
+private:
+    static void Add(Usage* usage, std::size_t bytes);
+
+    mutable std::mutex m_Mutex;
+    std::array<std::vector<GLuint>, Kind::COUNT> m_Released;
+    std::array<Usage, Kind::COUNT> m_Kinds;
+    std::array<Usage, static_cast<std::size_t>(Owner::COUNT)> m_Owners;
+    Usage m_Total;
+
+    // Touched only by GL thread, swapped with released names so deleting happens outside lock
+    std::array<std::vector<GLuint>, Kind::COUNT> m_Deleting;
+};
+
+extern GLResources g_GLResources;
+
+/**
+ * GL handle
+ *
+ * Move only owner of one GL object of given kind. Object is released to
+ * g_GLResources when handle is destroyed, reset or assigned another one.
+ * Owner reports size of the object's storage through Bytes(), it is
+ * accounted to owner tag given at creation and subtracted on release.
+ */
+template <GLResources::Kind KIND>
+class GLHandle {
+public:
+    GLHandle() = default;
+    ~GLHandle() { Reset(); }
+    GLHandle(const GLHandle&) = delete;
+    GLHandle& operator=(const GLHandle&) = delete;
+
+    GLHandle(GLHandle&& other) noexcept
+        : m_ID(other.m_ID)
+        , m_Owner(other.m_Owner)
+        , m_Bytes(other.m_Bytes) {
+        other.m_ID = 0;
+        other.m_Bytes = 0;
+    }
+
+    GLHandle& operator=(GLHandle&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            m_ID = other.m_ID;
+            m_Owner = other.m_Owner;
+            m_Bytes = other.m_Bytes;
+            other.m_ID = 0;
+            other.m_Bytes = 0;
+        }
+
+        return *this;
+    }
+
+    // Has to be called on GL thread
+    static GLHandle Create(GLResources::Owner owner) {
+        GLHandle handle;
+        handle.m_ID = g_GLResources.Create(KIND, owner);
+        handle.m_Owner = owner;
+        return handle;
+    }
+
+    GLuint ID() const { return m_ID; }
+    GLResources::Owner Owner() const { return m_Owner; }
+    explicit operator bool() const { return m_ID != 0; }
+
+    std::size_t Bytes() const { return m_Bytes; }
+    void Bytes(std::size_t bytes) {
+        g_GLResources.Account(KIND, m_Owner, m_Bytes, bytes);
+        m_Bytes = bytes;
+    }
+
+    void Reset() {
+        if (m_ID != 0) {
+            g_GLResources.Release(KIND, m_Owner, m_ID, m_Bytes);
+            m_ID = 0;
+            m_Bytes = 0;
+        }
+    }
+
+private:
+    GLuint m_ID{ 0 };
+    GLResources::Owner m_Owner{ GLResources::Owner::UNTAGGED };
+    std::size_t m_Bytes{ 0 };
+};
+
+using BufferHandle = GLHandle<GLResources::Kind::BUFFER>;
+using VertexArrayHandle = GLHandle<GLResources::Kind::VERTEX_ARRAY>;
+using TextureHandle = GLHandle<GLResources::Kind::TEXTURE>;
+using ProgramHandle = GLHandle<GLResources::Kind::PROGRAM>;
+using FramebufferHandle = GLHandle<GLResources::Kind::FRAMEBUFFER>;
+using RenderbufferHandle = GLHandle<GLResources::Kind::RENDERBUFFER>;
+using QueryHandle = GLHandle<GLResources::Kind::QUERY>;
+
+#endif
@@ -0,0 +1,185 @@
+#include "GLState.h"
+
+#include <algorithm>
+#include <numeric>
+
+GLState::GLState() {
+    Invalidate();
+    ResetStatistics();
+}
+
+void GLState::UseProgram(GLuint program) {
+    if (Update(m_Program, program, Call::PROGRAM)) {
+        glUseProgram(program);
+    }
+}
+
+void GLState::BindVertexArray(GLuint vertex_array) {
+    if (Update(m_VertexArray, vertex_array, Call::VERTEX_ARRAY)) {
+        glBindVertexArray(vertex_array);
+    }
+}
+
+void GLState::ActiveTexture(GLenum unit) {
+    if (Update(m_ActiveTexture, unit, Call::ACTIVE_TEXTURE)) {
+        glActiveTexture(unit);
+    }
+}
+
+void GLState::BindTexture(GLenum target, GLuint texture) {
+    int target_index = TargetIndex(target);
+    GLuint unit = m_ActiveTexture - GL_TEXTURE0;
+
+    // Binding of unknown target or on unknown unit cannot be cached
+    if (target_index < 0 || m_ActiveTexture == UNKNOWN || unit >= TEXTURE_UNITS) {
+        m_Issued[Call::TEXTURE]++;
+        glBindTexture(target, texture);
+        return;
+    }
+
+    if (Update(m_Textures[unit][target_index], texture, Call::TEXTURE)) {
+        glBindTexture(target, texture);
+    }
+}
+
+void GLState::BindTexture(GLuint unit, GLenum target, GLuint texture) {
+    ActiveTexture(GL_TEXTURE0 + unit);
+    BindTexture(target, texture);
+}
+
+void GLState::DepthTest(bool enabled) {
+    if (Update(m_DepthTest, enabled, Call::CAPABILITY)) {
+        enabled ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+    }
+}
+
+void GLState::DepthFunc(GLenum func) {
+    if (Update(m_DepthFunc, func, Call::DEPTH_FUNC)) {
+        glDepthFunc(func);
+    }
+}
+
+void GLState::DepthMask(bool enabled) {
+    if (Update(m_DepthMask, enabled, Call::WRITE_MASK)) {
+        glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+    }
+}
+
+void GLState::ColorMask(bool enabled) {
+    if (Update(m_ColorMask, enabled, Call::WRITE_MASK)) {
+        GLboolean mask = enabled ? GL_TRUE : GL_FALSE;
+        glColorMask(mask, mask, mask, mask);
+    }
+}
+
+void GLState::Blend(bool enabled) {
+    if (Update(m_Blend, enabled, Call::CAPABILITY)) {
+        enabled ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+    }
+}
+
+void GLState::BlendFunc(GLenum source, GLenum destination) {
+    if (m_BlendSource == source && m_BlendDestination == destination) {
+        m_Skipped[Call::BLEND_FUNC]++;
+        return;
+    }
+
+    m_BlendSource = source;
+    m_BlendDestination = destination;
+    m_Issued[Call::BLEND_FUNC]++;
+    glBlendFunc(source, destination);
+}
+
+void GLState::DeleteProgram(GLuint program) {
+    if (m_Program == program) {
+        m_Program = 0;
+    }
+
+    glDeleteProgram(program);
+}
+
+void GLState::DeleteVertexArray(GLuint vertex_array) {
+    DeleteVertexArrays(1, &vertex_array);
+}
+
+void GLState::DeleteVertexArrays(GLsizei count, const GLuint* vertex_arrays) {
+    for (GLsizei i = 0; i < count; i++) {
+        if (m_VertexArray == vertex_arrays[i]) {
+            m_VertexArray = 0;
+        }
+    }
+
+    glDeleteVertexArrays(count, vertex_arrays);
+}
+
+void GLState::DeleteTexture(GLuint texture) {
+    DeleteTextures(1, &texture);
+}
+
+void GLState::DeleteTextures(GLsizei count, const GLuint* textures) {
+    for (auto& unit : m_Textures) {
+        for (auto& bound : unit) {
+            if (std::find(textures, textures + count, bound) != textures + count) {
+                bound = 0;
+            }
+        }
+    }
+
+    glDeleteTextures(count, textures);
+}
+
+void GLState::Invalidate() {
+    m_Program = UNKNOWN;
+    m_VertexArray = UNKNOWN;
+    m_ActiveTexture = UNKNOWN;
+    for (auto& unit : m_Textures) {
+        unit.fill(UNKNOWN);
+    }
+    m_DepthTest = UNKNOWN;
+    m_DepthFunc = UNKNOWN;
+    m_DepthMask = UNKNOWN;
+    m_ColorMask = UNKNOWN;
+    m_Blend = UNKNOWN;
+    m_BlendSource = UNKNOWN;
+    m_BlendDestination = UNKNOWN;
+}
+
+std::uint64_t GLState::Issued() const {
+    return std::accumulate(m_Issued.begin(), m_Issued.end(), std::uint64_t{ 0 });
+}
+
+std::uint64_t GLState::Skipped() const {
+    return std::accumulate(m_Skipped.begin(), m_Skipped.end(), std::uint64_t{ 0 });
+}
+
+void GLState::ResetStatistics() {
+    m_Issued.fill(0);
+    m_Skipped.fill(0);
+}
+
+bool GLState::Update(GLuint& shadow, GLuint value, Call call) {
+    if (shadow == value) {
+        m_Skipped[call]++;
+        return false;
+    }
+
+    shadow = value;
+    m_Issued[call]++;
+    return true;
+}
+
+int GLState::TargetIndex(GLenum target) const {
+    switch (target) {
+    case GL_TEXTURE_2D:
+        return 0;
+
+    case GL_TEXTURE_CUBE_MAP:
+        return 1;
+
+    case GL_TEXTURE_BUFFER:
+        return 2;
+
+    default:
+        return -1;
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef GLState_h
+#define GLState_h
+
+#pragma warning(push, 0)
+#include <glad/glad.h>
+#pragma warning(pop)
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * GL state cache
+ *
+ * Shadows the part of OpenGL state the renderer touches every frame (current
+ * program, vertex array, texture units, depth function, write masks and blending) and
+ * forwards a call to the driver only if it would change that state.
+ * Filtered out calls are counted per kind so the savings can be measured.
+ * Every change of the shadowed state has to go through g_GLState, otherwise
+ * the cache goes stale. After code that touches the state behind its back
+ * (e.g. Dear ImGui backend) call Invalidate().
+ */
+class GLState {
+public:
+    enum Call : int {
+        PROGRAM = 0,
+        VERTEX_ARRAY,
+        ACTIVE_TEXTURE,
+        TEXTURE,
+        DEPTH_FUNC,
+        WRITE_MASK,
+        CAPABILITY,
+        BLEND_FUNC,
+
+        COUNT
+    };
+
+    static constexpr std::size_t TEXTURE_UNITS = 16;
+
+    GLState();
+
+    void UseProgram(GLuint program);
+    void BindVertexArray(GLuint vertex_array);
+    void ActiveTexture(GLenum unit);
+    void BindTexture(GLenum target, GLuint texture);
+    void BindTexture(GLuint unit, GLenum target, GLuint texture);
+    void DepthTest(bool enabled);
+    void DepthFunc(GLenum func);
+    void DepthMask(bool enabled);
+    // All color channels at once
+    void ColorMask(bool enabled);
+    void Blend(bool enabled);
+    void BlendFunc(GLenum source, GLenum destination);
+
+    // Deleting bound object implicitly rebinds 0, so cache has to be told about it
+    void DeleteProgram(GLuint program);
+    void DeleteVertexArray(GLuint vertex_array);
+    void DeleteVertexArrays(GLsizei count, const GLuint* vertex_arrays);
+    void DeleteTexture(GLuint texture);
+    void DeleteTextures(GLsizei count, const GLuint* textures);
+
+    // Forget everything, next call of each kind will be issued
+    void Invalidate();
+
+    std::uint64_t Issued(Call call) const { return m_Issued[call]; }
+    std::uint64_t Skipped(Call call) const { return m_Skipped[call]; }
+    std::uint64_t Issued() const;
+    std::uint64_t Skipped() const;
+    void ResetStatistics();
+
+private:
+    static constexpr GLuint UNKNOWN = ~0u;
+    static constexpr std::size_t TEXTURE_TARGETS = 3;
+
+    // Returns true if call has to be issued
+    bool Update(GLuint& shadow, GLuint value, Call call);
+    int TargetIndex(GLenum target) const;
+
+    GLuint m_Program;
+    GLuint m_VertexArray;
+    GLuint m_ActiveTexture;
+    std::array<std::array<GLuint, TEXTURE_TARGETS>, TEXTURE_UNITS> m_Textures;
+    GLuint m_DepthTest;
+    GLuint m_DepthFunc;
+    GLuint m_DepthMask;
+    GLuint m_ColorMask;
+    GLuint m_Blend;
+    GLuint m_BlendSource;
+    GLuint m_BlendDestination;
+
+    std::array<std::uint64_t, Call::COUNT> m_Issued;
+    std::array<std::uint64_t, Call::COUNT> m_Skipped;
+};
+
+extern GLState g_GLState;
+
+#endif
@@ -0,0 +1,93 @@
+#include "GPUTimers.h"
+
+#include <algorithm>
+#include <vector>
+
+void GPUTimers::Initialize() {
+    for (auto& queries : m_Queries) {
+        for (QueryHandle& query : queries) {
+            query = QueryHandle::Create(GLResources::Owner::DEBUG);
+        }
+    }
+}
+
+void GPUTimers::BeginFrame() {
+    m_Frame = (m_Frame + 1) % LATENCY;
+    Collect(m_Frame);
+}
+
+void GPUTimers::Begin(Pass pass) {
+    glBeginQuery(GL_TIME_ELAPSED, m_Queries[m_Frame][pass].ID());
+}
+
+void GPUTimers::End(Pass pass) {
+    glEndQuery(GL_TIME_ELAPSED);
+    m_Issued[m_Frame][pass] = true;
+}
+
+GPUTimers::Timing GPUTimers::Statistics(Pass pass) const {
+    Timing timing;
+    timing.Samples = m_SampleCount[pass];
+    if (timing.Samples == 0) {
+        return timing;
+    }
+
+    std::vector<GLuint64> sorted(m_Samples[pass].begin(), m_Samples[pass].begin() + timing.Samples);
+    std::sort(sorted.begin(), sorted.end());
+
+    GLuint64 total = 0;
+    for (GLuint64 sample : sorted) {
+        total += sample;
+    }
+
+    timing.Average = static_cast<float>(total) / timing.Samples / 1.0e6f;
+    timing.P99 = sorted[(timing.Samples - 1) * 99 / 100] / 1.0e6f;
+
+    return timing;
+}
+
+const char* GPUTimers::Name(Pass pass) {
+    switch (pass) {
+    case Pass::DEPTH:
+        return "Depth";
+    case Pass::DRAWABLES:
+        return "Drawables";
+    case Pass::SKYBOX:
+        return "Skybox";
+    case Pass::UPSCALE:
+        return "Upscale";
+    case Pass::UI:
+        return "UI";
+    default:
+        return "Unknown";
+    }
+}
+
+void GPUTimers::Collect(std::size_t frame) {
+    bool issued = std::any_of(m_Issued[frame].begin(), m_Issued[frame].end(), [](bool pass_issued) { return pass_issued; });
+    if (issued) {
+        m_LastFrame.fill(0.0f);
+        m_CollectedFrames++;
+    }
+
+    for (int pass = 0; pass < Pass::COUNT; pass++) {
+        if (!m_Issued[frame][pass]) {
+            continue;
+        }
+        m_Issued[frame][pass] = false;
+
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(m_Queries[frame][pass].ID(), GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            continue;
+        }
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(m_Queries[frame][pass].ID(), GL_QUERY_RESULT, &elapsed);
+
+        m_LastFrame[pass] = elapsed / 1.0e6f;
+        m_Samples[pass][m_NextSample[pass]] = elapsed;
+        m_NextSample[pass] = (m_NextSample[pass] + 1) % SAMPLES;
+        m_SampleCount[pass] = std::min(m_SampleCount[pass] + 1, SAMPLES);
+    }
+}
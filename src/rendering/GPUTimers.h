@@ -0,0 +1,81 @@
+#ifndef GPUTimers_h
+#define GPUTimers_h
+
+#include "GLResources.h"
+
+#pragma warning(push, 0)
+#include <glad/glad.h>
+#pragma warning(pop)
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * GPU timers
+ *
+ * Measures GPU time of each rendering pass with GL_TIME_ELAPSED queries.
+ * Queries are kept in a pool covering several frames and read back only
+ * when the pool wraps around, so waiting for results never stalls the
+ * pipeline. Results not available by then are dropped. Last SAMPLES
+ * results of each pass are kept for rolling statistics.
+ */
+class GPUTimers {
+public:
+    enum Pass : int {
+        DEPTH = 0,
+        DRAWABLES,
+        SKYBOX,
+        UPSCALE,
+        UI,
+
+        COUNT
+    };
+
+    struct Timing {
+        float Average{ 0.0f };  // Milliseconds
+        float P99{ 0.0f };      // Milliseconds
+        std::size_t Samples{ 0 };
+    };
+
+    static constexpr std::size_t LATENCY = 4;
+    static constexpr std::size_t SAMPLES = 128;
+
+    GPUTimers() = default;
+    ~GPUTimers() = default;
+    GPUTimers(const GPUTimers&) = delete;
+    GPUTimers& operator=(const GPUTimers&) = delete;
+    GPUTimers(GPUTimers&&) = delete;
+    GPUTimers& operator=(GPUTimers&&) = delete;
+
+    void Initialize();
+
+    // Collects results of the frame whose queries are about to be reused
+    void BeginFrame();
+    void Begin(Pass pass);
+    void End(Pass pass);
+
+    Timing Statistics(Pass pass) const;
+    // Milliseconds of pass in the most recently collected frame, zero if the frame did not run it
+    float LastFrame(Pass pass) const { return m_LastFrame[pass]; }
+    // Grows with every collected frame, tells when LastFrame changed
+    std::uint64_t CollectedFrames() const { return m_CollectedFrames; }
+    static const char* Name(Pass pass);
+
+private:
+    void Collect(std::size_t frame);
+
+    std::array<std::array<QueryHandle, Pass::COUNT>, LATENCY> m_Queries;
+    std::array<std::array<bool, Pass::COUNT>, LATENCY> m_Issued{};
+    std::size_t m_Frame{ 0 };
+
+    // Ring of samples in nanoseconds
+    std::array<std::array<GLuint64, SAMPLES>, Pass::COUNT> m_Samples{};
+    std::array<std::size_t, Pass::COUNT> m_SampleCount{};
+    std::array<std::size_t, Pass::COUNT> m_NextSample{};
+
+    std::array<float, Pass::COUNT> m_LastFrame{};
+    std::uint64_t m_CollectedFrames{ 0 };
+};
+
+#endif
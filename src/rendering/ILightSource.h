@@ -2,9 +2,17 @@
 #define ILighSource_h
 
 #include "ShaderProgram.h"
+#include "LightClusters.h"
 
 class ILightSource {
 public:
+    // Counts of lights of each kind select variant of light receiving programs
+    enum class Kind {
+        DIRECTIONAL,
+        POINT,
+        SPOT
+    };
+
     ILightSource() = default;
     virtual ~ILightSource() = default;
     ILightSource(const ILightSource&) = delete;
@@ -12,7 +20,13 @@ public:
     ILightSource(ILightSource&&) = delete;
     ILightSource& operator=(ILightSource&&) = delete;
 
-    virtual void SetLightProperties(const ShaderProgram& shader) = 0;
+    virtual Kind LightKind() const = 0;
+
+    // Lights affecting whole scene set uniforms of light receiving programs,
+    // index counts lights of the same kind
+    virtual void SetLightProperties(const ShaderProgram& shader, unsigned int index) { (void)shader; (void)index; }
+    // Lights with limited range are added to clusters every frame instead
+    virtual void AddToClusters(LightClusters& clusters) const { (void)clusters; }
 };
 
 #endif
@@ -1,6 +1,8 @@
 #ifndef IWidget_h
 #define IWidget_h
 
+#include "ShaderProgram.h"
+
 #include <string>
 
 class IWidget {
@@ -22,7 +24,17 @@ public:
     virtual void Draw() const = 0;
     virtual void NetworkDraw(std::string text) const = 0;
 
+    // Retained widget keeps its own geometry and is drawn with TEXT program instead of Draw()
+    virtual bool Retained() const { return false; }
+    virtual void DrawRetained(const ShaderProgram& shader) const {}
+
+    // Set when widget would look different than in the last drawn frame
+    bool Changed() const { return m_Changed; }
+    void ClearChanged() { m_Changed = false; }
+
 protected:
+    void MarkChanged() { m_Changed = true; }
+
     template <class T>
     void Align(T* value, const T& min, const T& max, EAlign align) const {
         if (align == EAlign::NONE) {
@@ -40,6 +52,9 @@ protected:
             return;
         }
     }
+
+private:
+    bool m_Changed{ true };
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "LightClusters.h"
+
+#include "GLState.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+void LightClusters::Initialize() {
+    const GLenum formats[3] = { GL_RGBA32F, GL_RG32UI, GL_R16UI };
+    for (int i = 0; i < 3; i++) {
+        m_Buffers[i] = BufferHandle::Create(GLResources::Owner::STREAMING);
+        m_Textures[i] = TextureHandle::Create(GLResources::Owner::STREAMING);
+        Upload(i, nullptr, 0);
+        g_GLState.BindTexture(GL_TEXTURE_BUFFER, m_Textures[i].ID());
+        glTexBuffer(GL_TEXTURE_BUFFER, formats[i], m_Buffers[i].ID());
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    m_Grid.assign(CLUSTERS * 2, 0);
+}
+
+void LightClusters::Clear() {
+    m_Lights.clear();
+}
+
+void LightClusters::Add(const Light& light) {
+    m_Lights.push_back(light);
+}
+
+void LightClusters::Build(const glm::mat4& view, const glm::mat4& projection, unsigned int width, unsigned int height) {
+    // Planes of perspective projection, glm matrices are indexed by column first
+    float near_plane = projection[3][2] / (projection[2][2] - 1.0f);
+    float far_plane = projection[3][2] / (projection[2][2] + 1.0f);
+    float slice_scale = static_cast<float>(SLICES) / std::log(far_plane / near_plane);
+    float slice_bias = -slice_scale * std::log(near_plane);
+    m_Scale = glm::vec4(static_cast<float>(TILES_X) / std::max(width, 1u), static_cast<float>(TILES_Y) / std::max(height, 1u), slice_scale, slice_bias);
+    m_Depth = glm::vec2(near_plane, far_plane);
+
+    auto slice = [&](float depth) {
+        int index = static_cast<int>(std::floor(std::log(depth) * slice_scale + slice_bias));
+        return static_cast<unsigned int>(std::clamp(index, 0, static_cast<int>(SLICES) - 1));
+    };
+    auto tile = [](float ndc, unsigned int tiles) {
+        int index = static_cast<int>(std::floor((ndc * 0.5f + 0.5f) * tiles));
+        return static_cast<unsigned int>(std::clamp(index, 0, static_cast<int>(tiles) - 1));
+    };
+
+    m_Assignments.clear();
+    m_LightTexels.clear();
+    std::fill(m_Grid.begin(), m_Grid.end(), 0);
+
+    for (std::size_t i = 0; i < m_Lights.size() && m_Assignments.size() < MAX_LIGHTS; i++) {
+        const Light& light = m_Lights[i];
+        float range = Range(light);
+        if (range <= 0.0f) {
+            continue;
+        }
+
+        glm::vec3 center = glm::vec3(view * glm::vec4(light.Position, 1.0f));
+        float depth = -center.z;
+        if (depth + range < near_plane || depth - range > far_plane) {
+            continue;
+        }
+
+        Assignment assignment;
+        assignment.Light = static_cast<std::uint16_t>(m_Assignments.size());
+        assignment.MinSlice = slice(std::max(depth - range, near_plane));
+        assignment.MaxSlice = slice(std::min(depth + range, far_plane));
+
+        // Sphere reaching behind near plane may cover any tile
+        if (depth - range <= near_plane) {
+            assignment.MinX = 0;
+            assignment.MaxX = TILES_X - 1;
+            assignment.MinY = 0;
+            assignment.MaxY = TILES_Y - 1;
+        } else {
+            // Conservative screen rectangle from corners of the box around the sphere
+            glm::vec2 lower(FLT_MAX), upper(-FLT_MAX);
+            for (int corner = 0; corner < 8; corner++) {
+                glm::vec3 offset((corner & 1) ? range : -range, (corner & 2) ? range : -range, (corner & 4) ? range : -range);
+                glm::vec4 clip = projection * glm::vec4(center + offset, 1.0f);
+                glm::vec2 ndc = glm::vec2(clip) / clip.w;
+                lower = glm::min(lower, ndc);
+                upper = glm::max(upper, ndc);
+            }
+            if (upper.x < -1.0f || lower.x > 1.0f || upper.y < -1.0f || lower.y > 1.0f) {
+                continue;
+            }
+
+            assignment.MinX = tile(lower.x, TILES_X);
+            assignment.MaxX = tile(upper.x, TILES_X);
+            assignment.MinY = tile(lower.y, TILES_Y);
+            assignment.MaxY = tile(upper.y, TILES_Y);
+        }
+
+        m_LightTexels.emplace_back(light.Position, range);
+        m_LightTexels.emplace_back(light.Ambient, light.Constant);
+        m_LightTexels.emplace_back(light.Diffuse, light.Linear);
+        m_LightTexels.emplace_back(light.Specular, light.Quadratic);
+        m_Assignments.push_back(assignment);
+
+        for (unsigned int z = assignment.MinSlice; z <= assignment.MaxSlice; z++) {
+            for (unsigned int y = assignment.MinY; y <= assignment.MaxY; y++) {
+                for (unsigned int x = assignment.MinX; x <= assignment.MaxX; x++) {
+                    m_Grid[((z * TILES_Y + y) * TILES_X + x) * 2 + 1]++;
+                }
+            }
+        }
+    }
+
+    // Counts are known, offsets make every cluster a contiguous range of the index list
+    std::uint32_t offset = 0;
+    for (std::size_t cluster = 0; cluster < CLUSTERS; cluster++) {
+        m_Grid[cluster * 2] = offset;
+        offset += m_Grid[cluster * 2 + 1];
+    }
+
+    m_Indices.resize(offset);
+    std::vector<std::uint32_t> filled(CLUSTERS, 0);
+    for (const Assignment& assignment : m_Assignments) {
+        for (unsigned int z = assignment.MinSlice; z <= assignment.MaxSlice; z++) {
+            for (unsigned int y = assignment.MinY; y <= assignment.MaxY; y++) {
+                for (unsigned int x = assignment.MinX; x <= assignment.MaxX; x++) {
+                    std::size_t cluster = (z * TILES_Y + y) * TILES_X + x;
+                    m_Indices[m_Grid[cluster * 2] + filled[cluster]++] = assignment.Light;
+                }
+            }
+        }
+    }
+
+    Upload(0, m_LightTexels.data(), m_LightTexels.size() * sizeof(glm::vec4));
+    Upload(1, m_Grid.data(), m_Grid.size() * sizeof(std::uint32_t));
+    Upload(2, m_Indices.data(), m_Indices.size() * sizeof(std::uint16_t));
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void LightClusters::Bind(const ShaderProgram& shader) const {
+    g_GLState.BindTexture(LIGHTS_UNIT, GL_TEXTURE_BUFFER, m_Textures[0].ID());
+    g_GLState.BindTexture(GRID_UNIT, GL_TEXTURE_BUFFER, m_Textures[1].ID());
+    g_GLState.BindTexture(INDICES_UNIT, GL_TEXTURE_BUFFER, m_Textures[2].ID());
+    g_GLState.ActiveTexture(GL_TEXTURE0);
+
+    shader.Uniform("clusterLights", static_cast<int>(LIGHTS_UNIT));
+    shader.Uniform("clusterGrid", static_cast<int>(GRID_UNIT));
+    shader.Uniform("clusterIndices", static_cast<int>(INDICES_UNIT));
+    shader.Uniform("clusterScale", m_Scale);
+    shader.Uniform("clusterDepth", m_Depth);
+    shader.Uniform("clusterSize", glm::vec4(TILES_X, TILES_Y, SLICES, 0.0f));
+}
+
+float LightClusters::Range(const Light& light) {
+    glm::vec3 brightest = glm::max(light.Ambient, glm::max(light.Diffuse, light.Specular));
+    float threshold = 256.0f * std::max(brightest.x, std::max(brightest.y, brightest.z));
+    if (threshold <= light.Constant) {
+        return 0.0f;
+    }
+
+    // Root of quadratic * d^2 + linear * d + constant = threshold
+    float c = light.Constant - threshold;
+    return (-light.Linear + std::sqrt(light.Linear * light.Linear - 4.0f * light.Quadratic * c)) / (2.0f * light.Quadratic);
+}
+
+void LightClusters::Upload(int buffer, const void* data, std::size_t size) {
+    // Orphaning lets the driver hand out fresh storage while last frame still reads the old one
+    glBindBuffer(GL_TEXTURE_BUFFER, m_Buffers[buffer].ID());
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_DRAW);
+    m_Buffers[buffer].Bytes(size);
+    if (size > 0) {
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, static_cast<GLsizeiptr>(size), data);
+    }
+}
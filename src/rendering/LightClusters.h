@@ -0,0 +1,103 @@
+#ifndef LightClusters_h
+#define LightClusters_h
+
+#include "GLResources.h"
+#include "ShaderProgram.h"
+
+#pragma warning(push, 0)
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#pragma warning(pop)
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Light clusters
+ *
+ * Clustered forward shading of point lights. View frustum is split into
+ * TILES_X x TILES_Y screen tiles and SLICES depth slices growing
+ * exponentially with distance. Every frame lights are assigned on CPU to
+ * clusters their range overlaps, and three texture buffers are uploaded:
+ * light parameters, offset and count of every cluster and the list of
+ * light indices the clusters point into. Fragment finds its cluster from
+ * window position and depth and shades only lights listed there, so cost
+ * per fragment depends on lights nearby, not on lights in the scene.
+ */
+class LightClusters {
+public:
+    static constexpr unsigned int TILES_X = 16;
+    static constexpr unsigned int TILES_Y = 9;
+    static constexpr unsigned int SLICES = 24;
+    static constexpr std::size_t CLUSTERS = TILES_X * TILES_Y * SLICES;
+    // Light indices are 16 bit
+    static constexpr std::size_t MAX_LIGHTS = 65535;
+
+    // Texture units of the buffers, above the ones used by materials
+    static constexpr GLuint LIGHTS_UNIT = 13;
+    static constexpr GLuint GRID_UNIT = 14;
+    static constexpr GLuint INDICES_UNIT = 15;
+
+    struct Light {
+        glm::vec3 Position;
+        glm::vec3 Ambient;
+        glm::vec3 Diffuse;
+        glm::vec3 Specular;
+        float Constant;
+        float Linear;
+        float Quadratic;
+    };
+
+    LightClusters() = default;
+    ~LightClusters() = default;
+    LightClusters(const LightClusters&) = delete;
+    LightClusters& operator=(const LightClusters&) = delete;
+    LightClusters(LightClusters&&) = delete;
+    LightClusters& operator=(LightClusters&&) = delete;
+
+    void Initialize();
+
+    // Lights are collected anew every frame
+    void Clear();
+    void Add(const Light& light);
+
+    // Assigns lights to clusters of perspective view and uploads the buffers
+    void Build(const glm::mat4& view, const glm::mat4& projection, unsigned int width, unsigned int height);
+    // Binds the buffers and sets uniforms of program using clusters
+    void Bind(const ShaderProgram& shader) const;
+
+    std::size_t Lights() const { return m_Lights.size(); }
+    // Sum of light counts over all clusters
+    std::size_t Assignments() const { return m_Indices.size(); }
+
+    // Distance at which light contributes less than 1/256 to any channel
+    static float Range(const Light& light);
+
+private:
+    // Texels of light in lights buffer
+    static constexpr std::size_t LIGHT_TEXELS = 4;
+
+    struct Assignment {
+        std::uint16_t Light;
+        unsigned int MinX, MaxX, MinY, MaxY, MinSlice, MaxSlice;
+    };
+
+    void Upload(int buffer, const void* data, std::size_t size);
+
+    std::vector<Light> m_Lights;
+    std::vector<Assignment> m_Assignments;
+    std::vector<glm::vec4> m_LightTexels;
+    std::vector<std::uint32_t> m_Grid;    // Offset and count of every cluster
+    std::vector<std::uint16_t> m_Indices;
+
+    BufferHandle m_Buffers[3];
+    TextureHandle m_Textures[3];
+
+    // Uniforms of the last build
+    glm::vec4 m_Scale{ 0.0f };    // Tiles per pixel in x and y, slice scale and bias
+    glm::vec2 m_Depth{ 0.0f };    // Near and far plane
+};
+
+#endif
@@ -3,15 +3,16 @@
 
 #include "../rendering/Drawable.h"
 
+// Registered line, owns no GL objects, every draw adds it to the batch of DebugDraw
 class Line : public Drawable {
 public:
     Line(glm::vec3 start, glm::vec3 end, glm::vec3 color);
     Line(const Line& other);
     Line& operator=(const Line& other);
-    ~Line();
+    ~Line() override = default;
 
     void Draw(const ShaderProgram& shader) const override;
-    void NetworkDraw(const ShaderProgram &shader, glm::mat4 local_to_world) const override;
+    bool LocalBounds(AABB* bounds) const override;
 
     const glm::vec3& Start() const { return m_Start; }
 
@@ -24,11 +25,6 @@ private:
     glm::vec3 m_Start;
     glm::vec3 m_End;
     glm::vec3 m_Color;
-    
-    GLuint m_VAO;
-    GLuint m_VBO;
-    
-    void SetupLine();
 };
 
 #endif
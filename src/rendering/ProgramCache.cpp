@@ -0,0 +1,97 @@
+#include "ProgramCache.h"
+
+#include "GLExtensions.h"
+#include "../utilities/Hash.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+std::uint64_t ProgramCache::Key(const std::vector<std::string>& sources) {
+    std::uint64_t hash = FNV_OFFSET_BASIS;
+    for (const std::string& source : sources) {
+        hash = Fnv1a(source, hash);
+    }
+
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+        const GLubyte* value = glGetString(name);
+        hash = Fnv1a(value != nullptr ? reinterpret_cast<const char*>(value) : "", hash);
+    }
+
+    return hash;
+}
+
+bool ProgramCache::Load(GLuint program, std::uint64_t key) {
+    if (!g_GLExtensions.HasProgramBinary()) {
+        return false;
+    }
+
+    std::ifstream file(Path(key), std::ios::binary);
+    std::error_code error;
+    std::uint64_t size = std::filesystem::file_size(Path(key), error);
+    if (!file || error) {
+        return false;
+    }
+
+    // Length of truncated or corrupt file is not trusted with an allocation
+    Header header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(Header));
+    if (!file || header.Magic != MAGIC || header.Length > size - sizeof(Header)) {
+        return false;
+    }
+
+    std::vector<char> binary(header.Length);
+    file.read(binary.data(), binary.size());
+    if (!file) {
+        return false;
+    }
+
+    g_GLExtensions.ProgramBinary(program, header.Format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+    // Rejected binary leaves program unlinked
+    GLint success = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    return success == GL_TRUE;
+}
+
+void ProgramCache::Retrievable(GLuint program) {
+    if (g_GLExtensions.HasProgramBinary()) {
+        g_GLExtensions.ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+void ProgramCache::Store(GLuint program, std::uint64_t key) {
+    if (!g_GLExtensions.HasProgramBinary()) {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    Header header{ MAGIC, 0, 0 };
+    std::vector<char> binary(length);
+    GLsizei written = 0;
+    GLenum format = 0;
+    g_GLExtensions.GetProgramBinary(program, length, &written, &format, binary.data());
+    header.Format = format;
+    header.Length = static_cast<std::uint32_t>(written);
+
+    std::error_code error;
+    std::filesystem::create_directories(DIRECTORY, error);
+
+    std::ofstream file(Path(key), std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cout << "Program binary failed to save at path: " << Path(key) << '\n';
+        return;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    file.write(binary.data(), header.Length);
+}
+
+std::string ProgramCache::Path(std::uint64_t key) {
+    return std::string(DIRECTORY) + "/" + HashToHex(key) + ".bin";
+}
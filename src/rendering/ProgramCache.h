@@ -0,0 +1,46 @@
+#ifndef ProgramCache_h
+#define ProgramCache_h
+
+#pragma warning(push, 0)
+#include <glad/glad.h>
+#pragma warning(pop)
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Program binary cache
+ *
+ * Stores linked programs as driver specific binaries, so following launches
+ * skip compilation. Entry is keyed by hash of shader sources together with
+ * GL vendor, renderer and version strings, so a driver update or edited
+ * shader simply misses the cache. Driver may still reject a binary, in that
+ * case caller compiles from source. Does nothing if the driver offers no
+ * binary formats.
+ */
+class ProgramCache {
+public:
+    static constexpr const char* DIRECTORY = "cache/programs";
+
+    static std::uint64_t Key(const std::vector<std::string>& sources);
+
+    // Returns true if program was linked from cached binary
+    static bool Load(GLuint program, std::uint64_t key);
+    // Call before linking, otherwise driver does not need to keep binary around
+    static void Retrievable(GLuint program);
+    static void Store(GLuint program, std::uint64_t key);
+
+private:
+    static constexpr std::uint32_t MAGIC = 0x4E494250;    // "PBIN"
+
+    struct Header {
+        std::uint32_t Magic;
+        std::uint32_t Format;
+        std::uint32_t Length;
+    };
+
+    static std::string Path(std::uint64_t key);
+};
+
+#endif
@@ -1,91 +1,131 @@
 #include "ShaderProgram.h"
 
+#include "GLState.h"
+#include "ProgramCache.h"
+
 ShaderProgram::Trait operator| (ShaderProgram::Trait lhs, ShaderProgram::Trait rhs) {
     return static_cast<ShaderProgram::Trait>(static_cast<unsigned int>(lhs) | static_cast<unsigned int>(rhs));
 }
 
 ShaderProgram::ShaderProgram()
-    : m_Traits(Trait::NONE) {
-    m_ID = glCreateProgram();
-}
-
-ShaderProgram::~ShaderProgram() {
-    glDeleteProgram(m_ID);
+    : m_Program(ProgramHandle::Create(GLResources::Owner::SHADERS))
+    , m_Traits(Trait::NONE) {
 }
 
 void ShaderProgram::Use() const {
-    glUseProgram(m_ID);
+    g_GLState.UseProgram(m_Program.ID());
 }
 
 void ShaderProgram::AttachShaders(const char *vertex_path, const char *fragment_path, const char *geometry_path) {
-    // Compile shaders from given files
-    unsigned int vertex_shader = AttachShader(vertex_path, GL_VERTEX_SHADER);
-    unsigned int fragment_shader = AttachShader(fragment_path, GL_FRAGMENT_SHADER);
-    unsigned int geometry_shader = geometry_path != nullptr ? AttachShader(geometry_path, GL_GEOMETRY_SHADER) : -1;
-
-    LinkProgram();
-
-    // Free memory
-    glDeleteShader(vertex_shader);
-    glDeleteShader(fragment_shader);
-    if(geometry_path != nullptr) {
-        glDeleteShader(geometry_shader);
+    IssueShaders(vertex_path, fragment_path, geometry_path);
+    FinishShaders();
+}
+
+void ShaderProgram::IssueShaders(const char *vertex_path, const char *fragment_path, const char *geometry_path) {
+    std::vector<std::string> sources = { Specialize(ReadShader(vertex_path)), Specialize(ReadShader(fragment_path)) };
+    if (geometry_path != nullptr) {
+        sources.push_back(Specialize(ReadShader(geometry_path)));
+    }
+
+    m_CacheKey = ProgramCache::Key(sources);
+    if (ProgramCache::Load(m_Program.ID(), m_CacheKey)) {
+        return;
+    }
+
+    // Compile shaders from given files, calls return before driver is done
+    const GLenum types[] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER };
+    const char *paths[] = { vertex_path, fragment_path, geometry_path };
+    for (std::size_t i = 0; i < sources.size(); i++) {
+        m_PendingShaders.push_back(AttachShader(sources[i], types[i]));
+        m_PendingPaths.push_back(paths[i]);
+    }
+
+    ProgramCache::Retrievable(m_Program.ID());
+    glLinkProgram(m_Program.ID());
+}
+
+void ShaderProgram::FinishShaders() {
+    if (!m_PendingShaders.empty()) {
+        // Querying status waits for compilation to finish
+        for (std::size_t i = 0; i < m_PendingShaders.size(); i++) {
+            CheckShader(m_PendingShaders[i], m_PendingPaths[i]);
+        }
+
+        if (CheckProgram()) {
+            ProgramCache::Store(m_Program.ID(), m_CacheKey);
+        }
+
+        // Free memory
+        for (unsigned int shader : m_PendingShaders) {
+            glDetachShader(m_Program.ID(), shader);
+            glDeleteShader(shader);
+        }
+        m_PendingShaders.clear();
+        m_PendingPaths.clear();
+    }
+
+    // Programs that were never issued have nothing to bind
+    GLint linked = GL_FALSE;
+    glGetProgramiv(m_Program.ID(), GL_LINK_STATUS, &linked);
+    if (linked == GL_TRUE) {
+        BindUniformBlock("Frame", UniformBlock::FRAME_BLOCK);
+        BindUniformBlock("Object", UniformBlock::OBJECT_BLOCK);
     }
 }
 
 int ShaderProgram::ID() const {
-    return m_ID;
+    return m_Program.ID();
 }
 
 void ShaderProgram::Uniform(const std::string &name, bool value) const {
-    glUniform1i(glGetUniformLocation(m_ID, name.c_str()), (int)value);
+    glUniform1i(glGetUniformLocation(m_Program.ID(), name.c_str()), (int)value);
 }
 
 void ShaderProgram::Uniform(const std::string &name, int value) const {
-    glUniform1i(glGetUniformLocation(m_ID, name.c_str()), value);
+    glUniform1i(glGetUniformLocation(m_Program.ID(), name.c_str()), value);
 }
 
 void ShaderProgram::Uniform(const std::string &name, float value) const {
-    glUniform1f(glGetUniformLocation(m_ID, name.c_str()), value);
+    glUniform1f(glGetUniformLocation(m_Program.ID(), name.c_str()), value);
 }
 
 void ShaderProgram::Uniform(const std::string &name, const glm::vec2 &vec) const {
-    glUniform2fv(glGetUniformLocation(m_ID, name.c_str()), 1, &vec[0]);
+    glUniform2fv(glGetUniformLocation(m_Program.ID(), name.c_str()), 1, &vec[0]);
 }
 
 void ShaderProgram::Uniform(const std::string &name, float x, float y) const {
-    glUniform2f(glGetUniformLocation(m_ID, name.c_str()), x, y);
+    glUniform2f(glGetUniformLocation(m_Program.ID(), name.c_str()), x, y);
 }
 
 void ShaderProgram::Uniform(const std::string &name, const glm::vec3 &vec) const {
-    glUniform3fv(glGetUniformLocation(m_ID, name.c_str()), 1, &vec[0]);
+    glUniform3fv(glGetUniformLocation(m_Program.ID(), name.c_str()), 1, &vec[0]);
 }
 
 void ShaderProgram::Uniform(const std::string &name, float x, float y, float z) const {
-    glUniform3f(glGetUniformLocation(m_ID, name.c_str()), x, y, z);
+    glUniform3f(glGetUniformLocation(m_Program.ID(), name.c_str()), x, y, z);
 }
 
 void ShaderProgram::Uniform(const std::string &name, const glm::vec4 &vec) const {
-    glUniform4fv(glGetUniformLocation(m_ID, name.c_str()), 1, &vec[0]);
+    glUniform4fv(glGetUniformLocation(m_Program.ID(), name.c_str()), 1, &vec[0]);
 }
 
 void ShaderProgram::Uniform(const std::string &name, float x, float y, float z, float w) const {
-    glUniform4f(glGetUniformLocation(m_ID, name.c_str()), x, y, z, w);
+    glUniform4f(glGetUniformLocation(m_Program.ID(), name.c_str()), x, y, z, w);
 }
 
 void ShaderProgram::Uniform(const std::string &name, const glm::mat2 &mat) const {
-    glUniformMatrix2fv(glGetUniformLocation(m_ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix2fv(glGetUniformLocation(m_Program.ID(), name.c_str()), 1, GL_FALSE, &mat[0][0]);
 }
 
 void ShaderProgram::Uniform(const std::string &name, const glm::mat3 &mat) const {
-    glUniformMatrix3fv(glGetUniformLocation(m_ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix3fv(glGetUniformLocation(m_Program.ID(), name.c_str()), 1, GL_FALSE, &mat[0][0]);
 }
 
 void ShaderProgram::Uniform(const std::string &name, const glm::mat4 &mat) const {
-    glUniformMatrix4fv(glGetUniformLocation(m_ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix4fv(glGetUniformLocation(m_Program.ID(), name.c_str()), 1, GL_FALSE, &mat[0][0]);
 }
 
-unsigned int ShaderProgram::AttachShader(const char *path, GLenum shader_type) {
+std::string ShaderProgram::ReadShader(const char *path) {
     std::string shader_code;
     std::fstream shader_file;
     
@@ -103,13 +143,37 @@ unsigned int ShaderProgram::AttachShader(const char *path, GLenum shader_type) {
         //TODO DebugLog
         std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ " << path << '\n' << e.what() << "\n\n";
     }
-    
+
+    return shader_code;
+}
+
+std::string ShaderProgram::Specialize(const std::string &source) const {
+    if (m_Defines.empty()) {
+        return source;
+    }
+
+    // #version has to stay the first statement
+    std::size_t line_end = source.find('\n');
+    if (source.compare(0, 8, "#version") != 0 || line_end == std::string::npos) {
+        return m_Defines + source;
+    }
+
+    return source.substr(0, line_end + 1) + m_Defines + source.substr(line_end + 1);
+}
+
+unsigned int ShaderProgram::AttachShader(const std::string &source, GLenum shader_type) {
     // Compile shader
     unsigned int shader = glCreateShader(shader_type);
-    const char *shader_code_ptr = shader_code.c_str();
+    const char *shader_code_ptr = source.c_str();
     glShaderSource(shader, 1, &shader_code_ptr, nullptr);
     glCompileShader(shader);
     
+    glAttachShader(m_Program.ID(), shader);
+    
+    return shader;
+}
+
+void ShaderProgram::CheckShader(unsigned int shader, const std::string &path) {
     // Check compile errors
     GLint success;
     GLchar info_log[1024];
@@ -119,22 +183,26 @@ unsigned int ShaderProgram::AttachShader(const char *path, GLenum shader_type) {
         glGetShaderInfoLog(shader, 1024, NULL, info_log);
         std::cout << "ERROR::SHADER_COMPILATION_ERROR " << path << '\n' << info_log << "\n\n";
     }
-    
-    glAttachShader(m_ID, shader);
-    
-    return shader;
 }
 
-void ShaderProgram::LinkProgram() {
-    glLinkProgram(m_ID);
-    
+bool ShaderProgram::CheckProgram() {
     // Check linking errors
     int success;
     char info_log[1024];
-    glGetProgramiv(m_ID, GL_LINK_STATUS, &success);
+    glGetProgramiv(m_Program.ID(), GL_LINK_STATUS, &success);
     if (!success) {
         //TODO DebugLog
-        glGetProgramInfoLog(m_ID, 1024, nullptr, info_log);
+        glGetProgramInfoLog(m_Program.ID(), 1024, nullptr, info_log);
         std::cout << "ERROR::LINKING_SHADERS_ERROR\n" << info_log << "\n\n";
     }
+
+    return success == GL_TRUE;
+}
+
+void ShaderProgram::BindUniformBlock(const char *name, UniformBlock binding) {
+    // Shaders not declaring the block simply do not use it
+    GLuint index = glGetUniformBlockIndex(m_Program.ID(), name);
+    if (index != GL_INVALID_INDEX) {
+        glUniformBlockBinding(m_Program.ID(), index, binding);
+    }
 }
@@ -6,10 +6,14 @@
 #include <glm/glm.hpp>
 #pragma warning(pop)
 
+#include "GLResources.h"
+
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <vector>
 
 class ShaderProgram {
 public:
@@ -19,13 +23,22 @@ public:
         PHONG,
         SKYBOX,
         TEXT,
+        DEPTH,
+        DEBUG_LINES,
         
         COUNT
     };
 
     enum Trait : unsigned char {
         NONE = 0,
-        LIGHT_RECEIVER = 1 << 0
+        LIGHT_RECEIVER = 1 << 0,
+        DEPTH_ONLY = 1 << 1     // Depth pre-pass, drawables that do not write depth skip it
+    };
+
+    // Binding points of std140 uniform blocks shared by all shaders
+    enum UniformBlock : GLuint {
+        FRAME_BLOCK = 0,    // Frame { pv, skyboxPv, viewPos }
+        OBJECT_BLOCK        // Object { model }
     };
 
     ShaderProgram();
@@ -34,14 +47,21 @@ public:
     ShaderProgram& operator=(const ShaderProgram&) = delete;
     ShaderProgram(ShaderProgram&&) = default;
     ShaderProgram& operator=(ShaderProgram&&) = default;
-    ~ShaderProgram();
+    ~ShaderProgram() = default;
     
     void AttachShaders(const char *vertex_path, const char *fragment_path, const char *geometry_path = nullptr);
+    // AttachShaders split in two, driver compiles issued programs in parallel until they are finished
+    void IssueShaders(const char *vertex_path, const char *fragment_path, const char *geometry_path = nullptr);
+    void FinishShaders();
     void Use() const;
     int ID() const;
     
     Trait Traits() const { return m_Traits; }
     void Traits(Trait traits) { m_Traits = traits; }
+
+    // Lines inserted after #version of every shader, set before issuing to specialize program
+    const std::string& Defines() const { return m_Defines; }
+    void Defines(const std::string& defines) { m_Defines = defines; }
     
     // Setters for OpenGL shaders
     void Uniform(const std::string &name, bool value) const;
@@ -58,11 +78,21 @@ public:
     void Uniform(const std::string &name, const glm::mat4 &mat) const;
     
 private:
-    void LinkProgram();
-    unsigned int AttachShader(const char *path, GLenum shader);
+    bool CheckProgram();
+    void BindUniformBlock(const char *name, UniformBlock binding);
+    std::string ReadShader(const char *path);
+    std::string Specialize(const std::string &source) const;
+    unsigned int AttachShader(const std::string &source, GLenum shader);
+    void CheckShader(unsigned int shader, const std::string &path);
     
-    unsigned int m_ID;
+    ProgramHandle m_Program;
     Trait m_Traits;
+    std::string m_Defines;
+
+    // Shaders being compiled between IssueShaders and FinishShaders
+    std::vector<unsigned int> m_PendingShaders;
+    std::vector<std::string> m_PendingPaths;
+    std::uint64_t m_CacheKey{ 0 };
 };
 
 ShaderProgram::Trait operator| (ShaderProgram::Trait lhs, ShaderProgram::Trait rhs);
@@ -0,0 +1,59 @@
+#include "ShaderVariants.h"
+
+#include <algorithm>
+
+std::uint32_t ShaderVariants::Defines::Key() const {
+    std::uint32_t dir_lights = std::min(DirLights, MAX_DIR_LIGHTS);
+    std::uint32_t spot_lights = std::min(SpotLights, MAX_SPOT_LIGHTS);
+
+    // Diffuse map is sampled by every variant, only specular map selects code
+    std::uint32_t maps = Maps & SPECULAR_MAP;
+
+    return dir_lights | (spot_lights << 8) | (static_cast<std::uint32_t>(PointLights) << 16) | (maps << 24);
+}
+
+std::string ShaderVariants::Defines::Source() const {
+    std::string source;
+    source += "#define DIR_LIGHTS " + std::to_string(std::min(DirLights, MAX_DIR_LIGHTS)) + "\n";
+    source += "#define POINT_LIGHTS " + std::to_string(PointLights ? 1 : 0) + "\n";
+    source += "#define SPOT_LIGHTS " + std::to_string(std::min(SpotLights, MAX_SPOT_LIGHTS)) + "\n";
+    source += "#define SPECULAR_MAP " + std::to_string((Maps & SPECULAR_MAP) ? 1 : 0) + "\n";
+
+    return source;
+}
+
+ShaderVariants::ShaderVariants(const char* vertex_path, const char* fragment_path, ShaderProgram::Trait traits)
+    : m_VertexPath(vertex_path)
+    , m_FragmentPath(fragment_path)
+    , m_Traits(traits) {
+}
+
+const ShaderProgram& ShaderVariants::Variant(const Defines& defines) {
+    std::unique_ptr<ShaderProgram>& variant = m_Variants[defines.Key()];
+    if (variant == nullptr) {
+        variant = std::make_unique<ShaderProgram>();
+        variant->Traits(m_Traits);
+        variant->Defines(defines.Source());
+        variant->AttachShaders(m_VertexPath.c_str(), m_FragmentPath.c_str());
+    }
+
+    return *variant;
+}
+
+void ShaderVariants::Prewarm(const std::vector<Defines>& defines) {
+    std::vector<ShaderProgram*> issued;
+    for (const Defines& variant_defines : defines) {
+        std::unique_ptr<ShaderProgram>& variant = m_Variants[variant_defines.Key()];
+        if (variant == nullptr) {
+            variant = std::make_unique<ShaderProgram>();
+            variant->Traits(m_Traits);
+            variant->Defines(variant_defines.Source());
+            variant->IssueShaders(m_VertexPath.c_str(), m_FragmentPath.c_str());
+            issued.push_back(variant.get());
+        }
+    }
+
+    for (ShaderProgram* variant : issued) {
+        variant->FinishShaders();
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef ShaderVariants_h
+#define ShaderVariants_h
+
+#include "ShaderProgram.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Shader variants
+ *
+ * Program specialized at compile time by feature defines instead of
+ * branching at run time. Defines of light receivers count lights of each
+ * kind in the scene and tell which material maps drawable has, so code
+ * of absent lights and maps is not compiled at all. Variant is compiled
+ * the first time it is requested and kept by its key, program cache makes
+ * it cheap on following launches. Variants known ahead of drawing can be
+ * prewarmed together instead.
+ */
+class ShaderVariants {
+public:
+    static constexpr unsigned int MAX_DIR_LIGHTS = 4;
+    static constexpr unsigned int MAX_SPOT_LIGHTS = 4;
+
+    enum Map : unsigned int {
+        NO_MAPS = 0,
+        // Diffuse map is sampled by all variants, the bit does not select one
+        DIFFUSE_MAP = 1 << 0,
+        SPECULAR_MAP = 1 << 1
+    };
+
+    struct Defines {
+        unsigned int DirLights{ 0 };
+        // Point lights are looked up in clusters, their count does not change the code
+        bool PointLights{ false };
+        unsigned int SpotLights{ 0 };
+        unsigned int Maps{ NO_MAPS };
+
+        std::uint32_t Key() const;
+        // #define lines inserted into shader sources
+        std::string Source() const;
+    };
+
+    ShaderVariants(const char* vertex_path, const char* fragment_path, ShaderProgram::Trait traits = ShaderProgram::Trait::NONE);
+
+    // Compiles variant on first request, counts over the limits are clamped
+    const ShaderProgram& Variant(const Defines& defines);
+    // Issues all missing variants before waiting for any, so driver compiles them in parallel
+    void Prewarm(const std::vector<Defines>& defines);
+
+    std::size_t Compiled() const { return m_Variants.size(); }
+
+private:
+    std::string m_VertexPath;
+    std::string m_FragmentPath;
+    ShaderProgram::Trait m_Traits;
+
+    std::unordered_map<std::uint32_t, std::unique_ptr<ShaderProgram>> m_Variants;
+};
+
+#endif
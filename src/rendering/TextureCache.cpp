@@ -0,0 +1,179 @@
+#include "TextureCache.h"
+
+#include "GLExtensions.h"
+#include "GLState.h"
+#include "../utilities/Hash.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+std::uint64_t TextureCache::Key(GLenum target, const std::vector<std::string>& paths) {
+    std::uint64_t hash = Fnv1a(&target, sizeof(target));
+    for (const std::string& path : paths) {
+        hash = Fnv1a(path, hash);
+
+        // Missing file hashes as zeros, its entry is never written anyway
+        std::error_code error;
+        std::uint64_t size = std::filesystem::file_size(path, error);
+        std::int64_t time = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+        hash = Fnv1a(&size, sizeof(size), hash);
+        hash = Fnv1a(&time, sizeof(time), hash);
+    }
+
+    return hash;
+}
+
+std::string TextureCache::Path(std::uint64_t key) {
+    return std::string(DIRECTORY) + "/" + HashToHex(key) + ".tex";
+}
+
+GLenum TextureCache::InternalFormat(int channels) {
+    bool s3tc = g_GLExtensions.HasTextureCompressionS3TC();
+
+    switch (channels) {
+    case 1:
+        return GL_COMPRESSED_RED_RGTC1;
+    case 2:
+        return GL_COMPRESSED_RG_RGTC2;
+    case 4:
+        return s3tc ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_RGBA;
+    default:
+        return s3tc ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_RGB;
+    }
+}
+
+GLenum TextureCache::Format(int channels) {
+    switch (channels) {
+    case 1:
+        return GL_RED;
+    case 2:
+        return GL_RG;
+    case 4:
+        return GL_RGBA;
+    default:
+        return GL_RGB;
+    }
+}
+
+bool TextureCache::Parse(const MappedFile& file, GLenum target, std::vector<Level>* levels) {
+    if (file.Size() < sizeof(Header)) {
+        return false;
+    }
+
+    Header header;
+    std::memcpy(&header, file.Data(), sizeof(Header));
+    if (header.Magic != MAGIC || header.Version != VERSION || header.Target != target) {
+        return false;
+    }
+
+    std::size_t table_end = sizeof(Header) + static_cast<std::size_t>(header.Levels) * sizeof(LevelEntry);
+    if (header.Levels == 0 || file.Size() < table_end) {
+        return false;
+    }
+
+    levels->clear();
+    for (std::uint32_t i = 0; i < header.Levels; i++) {
+        LevelEntry entry;
+        std::memcpy(&entry, file.Data() + sizeof(Header) + i * sizeof(LevelEntry), sizeof(LevelEntry));
+        if (entry.Offset > file.Size() - table_end || entry.Size > file.Size() - table_end - entry.Offset) {
+            return false;
+        }
+        if (entry.Format == 0 && !Supported(entry.InternalFormat)) {
+            return false;
+        }
+
+        Level level;
+        level.Target = entry.Target;
+        level.Mip = static_cast<GLint>(entry.Mip);
+        level.Width = static_cast<GLsizei>(entry.Width);
+        level.Height = static_cast<GLsizei>(entry.Height);
+        level.InternalFormat = entry.InternalFormat;
+        level.Format = entry.Format;
+        level.Data = file.Data() + table_end + entry.Offset;
+        level.Size = static_cast<std::size_t>(entry.Size);
+        levels->push_back(level);
+    }
+
+    return true;
+}
+
+void TextureCache::Store(GLuint texture, GLenum target, GLenum format, std::uint64_t key) {
+    g_GLState.BindTexture(target, texture);
+
+    GLint max_level = 0;
+    glGetTexParameteriv(target, GL_TEXTURE_MAX_LEVEL, &max_level);
+
+    // Levels are read back one by one, this stalls but happens only when entry is created
+    std::vector<LevelEntry> entries;
+    std::vector<unsigned char> data;
+    GLenum first_face = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : GL_TEXTURE_2D;
+    GLenum faces = target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    for (GLenum face = first_face; face < first_face + faces; face++) {
+        for (GLint mip = 0; mip <= max_level; mip++) {
+            GLint width = 0, height = 0, internal_format = 0, compressed = GL_FALSE;
+            glGetTexLevelParameteriv(face, mip, GL_TEXTURE_WIDTH, &width);
+            glGetTexLevelParameteriv(face, mip, GL_TEXTURE_HEIGHT, &height);
+            if (width == 0 || height == 0) {
+                break;
+            }
+            glGetTexLevelParameteriv(face, mip, GL_TEXTURE_INTERNAL_FORMAT, &internal_format);
+            glGetTexLevelParameteriv(face, mip, GL_TEXTURE_COMPRESSED, &compressed);
+
+            LevelEntry entry{};
+            entry.Target = face;
+            entry.Mip = static_cast<std::uint32_t>(mip);
+            entry.Width = static_cast<std::uint32_t>(width);
+            entry.Height = static_cast<std::uint32_t>(height);
+            entry.InternalFormat = static_cast<std::uint32_t>(internal_format);
+            entry.Offset = data.size();
+
+            if (compressed == GL_TRUE) {
+                GLint size = 0;
+                glGetTexLevelParameteriv(face, mip, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+                entry.Size = static_cast<std::uint64_t>(size);
+                data.resize(data.size() + entry.Size);
+                glGetCompressedTexImage(face, mip, data.data() + entry.Offset);
+            } else {
+                GLint channels = format == GL_RED ? 1 : format == GL_RG ? 2 : format == GL_RGBA ? 4 : 3;
+                entry.Format = format;
+                entry.Size = static_cast<std::uint64_t>(width) * height * channels;
+                data.resize(data.size() + entry.Size);
+                glGetTexImage(face, mip, format, GL_UNSIGNED_BYTE, data.data() + entry.Offset);
+            }
+
+            entries.push_back(entry);
+        }
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    Header header{ MAGIC, VERSION, target, static_cast<std::uint32_t>(entries.size()) };
+
+    std::error_code error;
+    std::filesystem::create_directories(DIRECTORY, error);
+
+    std::ofstream file(Path(key), std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cout << "Texture cache failed to save at path: " << Path(key) << '\n';
+        return;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(LevelEntry));
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+bool TextureCache::Supported(GLenum internal_format) {
+    switch (internal_format) {
+    case GL_COMPRESSED_RED_RGTC1:
+    case GL_COMPRESSED_RG_RGTC2:
+        return true;
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        return g_GLExtensions.HasTextureCompressionS3TC();
+    default:
+        return false;
+    }
+}
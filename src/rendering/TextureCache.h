@@ -0,0 +1,77 @@
+#ifndef TextureCache_h
+#define TextureCache_h
+
+#include "../utilities/MappedFile.h"
+
+#pragma warning(push, 0)
+#include <glad/glad.h>
+#pragma warning(pop)
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Texture cache
+ *
+ * Stores textures in the form they are uploaded in: every face with complete
+ * mip chain, block compressed when the driver supports the format. Loading
+ * an entry needs only a memory map and one upload call per level. Entry is
+ * keyed by texture target together with path, size and modification time of
+ * each source image, so an edited image simply misses the cache.
+ */
+class TextureCache {
+public:
+    static constexpr const char* DIRECTORY = "cache/textures";
+
+    // One face of one mip level, Format is zero for compressed data
+    struct Level {
+        GLenum Target{ GL_TEXTURE_2D };
+        GLint Mip{ 0 };
+        GLsizei Width{ 0 };
+        GLsizei Height{ 0 };
+        GLenum InternalFormat{ GL_RGB };
+        GLenum Format{ 0 };
+        const unsigned char* Data{ nullptr };
+        std::size_t Size{ 0 };
+    };
+
+    static std::uint64_t Key(GLenum target, const std::vector<std::string>& paths);
+    static std::string Path(std::uint64_t key);
+
+    // Internal format textures with given number of channels are stored in
+    static GLenum InternalFormat(int channels);
+    static GLenum Format(int channels);
+
+    // Returns false if file is not valid entry or uses format the driver does not support
+    static bool Parse(const MappedFile& file, GLenum target, std::vector<Level>* levels);
+    // Reads all levels of texture back from the driver, format is used for uncompressed ones
+    static void Store(GLuint texture, GLenum target, GLenum format, std::uint64_t key);
+
+private:
+    static constexpr std::uint32_t MAGIC = 0x43584554;    // "TEXC"
+    static constexpr std::uint32_t VERSION = 1;
+
+    struct Header {
+        std::uint32_t Magic;
+        std::uint32_t Version;
+        std::uint32_t Target;
+        std::uint32_t Levels;
+    };
+
+    struct LevelEntry {
+        std::uint32_t Target;
+        std::uint32_t Mip;
+        std::uint32_t Width;
+        std::uint32_t Height;
+        std::uint32_t InternalFormat;
+        std::uint32_t Format;
+        std::uint64_t Offset;    // From the end of level table
+        std::uint64_t Size;
+    };
+
+    static bool Supported(GLenum internal_format);
+};
+
+#endif
@@ -0,0 +1,480 @@
+#include "TextureLoader.h"
+
+#include "GLState.h"
+
+#pragma warning(push, 0)
+#include <stb_image.h>
+#pragma warning(pop)
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+
+TextureLoader::~TextureLoader() {
+    StopThreads();
+}
+
+void TextureLoader::Initialize(unsigned int threads) {
+    m_Stopping = false;
+    for (unsigned int i = 0; i < threads; i++) {
+        m_Threads.emplace_back(&TextureLoader::WorkerLoop, this);
+    }
+
+    glGenBuffers(1, &m_UnpackBuffer);
+}
+
+void TextureLoader::Destroy() {
+    StopThreads();
+
+    // Textures of unfinished requests keep their placeholders
+    while (!m_Requests.empty()) {
+        Release(m_Requests.front().get());
+    }
+    m_Jobs.clear();
+    m_Ready.clear();
+    m_Uploading = nullptr;
+    // Textures are released even if someone still holds them, they are not usable without context anyway
+    m_Loaded.clear();
+
+    glDeleteBuffers(1, &m_UnpackBuffer);
+    m_UnpackBuffer = 0;
+    g_GLResources.Account(GLResources::Kind::BUFFER, GLResources::Owner::STREAMING, m_UnpackBytes, 0);
+    m_UnpackBytes = 0;
+}
+
+GLuint TextureLoader::Load(const std::string& path, GLResources::Owner owner) {
+    std::string key = Resolve(path);
+    auto loaded = m_Loaded.find(key);
+    if (loaded != m_Loaded.end()) {
+        loaded->second.Users++;
+        return loaded->second.Texture.ID();
+    }
+
+    auto request = std::make_unique<Request>();
+    request->Target = GL_TEXTURE_2D;
+    request->Owner = owner;
+    request->Faces.resize(1);
+    request->Faces[0].Path = path;
+
+    return Add(std::move(key), std::move(request));
+}
+
+GLuint TextureLoader::LoadCubemap(const std::array<std::string, 6>& faces, GLResources::Owner owner) {
+    // Separator cannot appear in a path, so 2D and cube keys never collide
+    std::string key;
+    for (const std::string& face : faces) {
+        key += Resolve(face) + '\0';
+    }
+    auto loaded = m_Loaded.find(key);
+    if (loaded != m_Loaded.end()) {
+        loaded->second.Users++;
+        return loaded->second.Texture.ID();
+    }
+
+    auto request = std::make_unique<Request>();
+    request->Target = GL_TEXTURE_CUBE_MAP;
+    request->Owner = owner;
+    request->Faces.resize(faces.size());
+    for (std::size_t i = 0; i < faces.size(); i++) {
+        request->Faces[i].Path = faces[i];
+    }
+
+    return Add(std::move(key), std::move(request));
+}
+
+void TextureLoader::Unload(GLuint texture) {
+    auto loaded = std::find_if(m_Loaded.begin(), m_Loaded.end(),
+                               [texture](const auto& entry) { return entry.second.Texture.ID() == texture; });
+    if (loaded == m_Loaded.end()) {
+        return;
+    }
+
+    // Request still in flight finds its entry gone and is dropped when it comes up for upload
+    if (--loaded->second.Users == 0) {
+        m_Loaded.erase(loaded);
+    }
+}
+
+bool TextureLoader::Update(std::size_t budget) {
+    bool completed = false;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_UnpackBuffer);
+    while (budget > 0) {
+        if (m_Uploading == nullptr) {
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                if (m_Ready.empty()) {
+                    break;
+                }
+                m_Uploading = m_Ready.front();
+                m_Ready.pop_front();
+            }
+
+            if (Find(*m_Uploading) == nullptr || !Prepare(m_Uploading)) {
+                Release(m_Uploading);
+                m_Uploading = nullptr;
+                continue;
+            }
+
+            // Orphan storage used by previous image, driver may still be reading it
+            m_UploadSize = 0;
+            for (const TextureCache::Level& level : m_Uploading->Levels) {
+                m_UploadSize += level.Size;
+            }
+            m_Uploaded = 0;
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, m_UploadSize, nullptr, GL_STREAM_DRAW);
+            g_GLResources.Account(GLResources::Kind::BUFFER, GLResources::Owner::STREAMING, m_UnpackBytes, m_UploadSize);
+            m_UnpackBytes = m_UploadSize;
+        }
+
+        // Written range was never used by GL, no need to synchronize
+        std::size_t slice = std::min(budget, m_UploadSize - m_Uploaded);
+        void* destination = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, m_Uploaded, slice,
+                                             GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (destination == nullptr) {
+            std::cout << "ERROR::TEXTURE_LOADER::MAP_FAILED\n";
+            break;
+        }
+        Copy(*m_Uploading, m_Uploaded, slice, static_cast<unsigned char*>(destination));
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        m_Uploaded += slice;
+        budget -= slice;
+
+        if (m_Uploaded == m_UploadSize) {
+            if (Entry* entry = Find(*m_Uploading)) {
+                Complete(*m_Uploading, &entry->Texture);
+            }
+            Release(m_Uploading);
+            m_Uploading = nullptr;
+            completed = true;
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    return completed;
+}
+
+void TextureLoader::Finish() {
+    while (!m_Requests.empty()) {
+        if (m_Uploading == nullptr) {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Decoded.wait(lock, [this]() { return !m_Ready.empty() || m_Threads.empty(); });
+            if (m_Ready.empty()) {
+                return;
+            }
+        }
+
+        Update(std::numeric_limits<std::size_t>::max());
+    }
+}
+
+std::string TextureLoader::Resolve(const std::string& path) {
+    std::error_code error;
+    std::filesystem::path resolved = std::filesystem::weakly_canonical(path, error);
+    if (error) {
+        resolved = std::filesystem::path(path).lexically_normal();
+    }
+
+    return resolved.generic_string();
+}
+
+GLuint TextureLoader::Add(std::string key, std::unique_ptr<Request> request) {
+    Entry entry;
+    entry.Texture = CreatePlaceholder(request->Target, request->Owner);
+    entry.Users = 1;
+
+    GLuint texture = entry.Texture.ID();
+    request->Key = key;
+    request->Texture = texture;
+    m_Loaded.emplace(std::move(key), std::move(entry));
+    Enqueue(std::move(request));
+
+    return texture;
+}
+
+TextureLoader::Entry* TextureLoader::Find(const Request& request) {
+    // Same key may have been unloaded and requested again, then it is another texture
+    auto loaded = m_Loaded.find(request.Key);
+    if (loaded == m_Loaded.end() || loaded->second.Texture.ID() != request.Texture) {
+        return nullptr;
+    }
+
+    return &loaded->second;
+}
+
+TextureHandle TextureLoader::CreatePlaceholder(GLenum target, GLResources::Owner owner) {
+    const unsigned char gray[3] = { 128, 128, 128 };
+
+    TextureHandle texture = TextureHandle::Create(owner);
+    g_GLState.BindTexture(target, texture.ID());
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (target == GL_TEXTURE_CUBE_MAP) {
+        for (GLenum face = 0; face < 6; face++) {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, gray);
+        }
+
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, gray);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    return texture;
+}
+
+void TextureLoader::Enqueue(std::unique_ptr<Request> request) {
+    // Faces are decoded only if cache lookup fails
+    request->Remaining = 1;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Jobs.push_back({ request.get(), CACHED });
+    }
+    m_JobReady.notify_all();
+
+    m_Requests.push_back(std::move(request));
+}
+
+void TextureLoader::WorkerLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_JobReady.wait(lock, [this]() { return m_Stopping || !m_Jobs.empty(); });
+            if (m_Stopping) {
+                return;
+            }
+            job = m_Jobs.front();
+            m_Jobs.pop_front();
+        }
+
+        Request* request = job.ToDecode;
+        if (job.Face == CACHED) {
+            std::vector<std::string> paths;
+            for (const Image& face : request->Faces) {
+                paths.push_back(face.Path);
+            }
+            request->CacheKey = TextureCache::Key(request->Target, paths);
+
+            if (!request->Cached.Open(TextureCache::Path(request->CacheKey))
+                || !TextureCache::Parse(request->Cached, request->Target, &request->Levels)) {
+                request->Cached.Close();
+                request->Levels.clear();
+
+                // Not in cache, decode every face
+                {
+                    std::lock_guard<std::mutex> lock(m_Mutex);
+                    request->Remaining = request->Faces.size();
+                    for (std::size_t i = 0; i < request->Faces.size(); i++) {
+                        m_Jobs.push_back({ request, i });
+                    }
+                }
+                m_JobReady.notify_all();
+                continue;
+            }
+        } else {
+            // Cubemap faces are always uploaded as RGB and have no mipmaps
+            Image& image = request->Faces[job.Face];
+            int desired_channels = request->Target == GL_TEXTURE_CUBE_MAP ? 3 : 0;
+            image.Pixels = stbi_load(image.Path.c_str(), &image.Width, &image.Height, &image.Channels, desired_channels);
+            if (desired_channels != 0) {
+                image.Channels = desired_channels;
+            }
+            if (image.Pixels != nullptr && request->Target == GL_TEXTURE_2D) {
+                BuildMips(&image);
+            }
+        }
+
+        bool decoded;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            decoded = --request->Remaining == 0;
+            if (decoded) {
+                m_Ready.push_back(request);
+            }
+        }
+        if (decoded) {
+            m_Decoded.notify_all();
+        }
+    }
+}
+
+void TextureLoader::StopThreads() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_JobReady.notify_all();
+
+    for (std::thread& thread : m_Threads) {
+        thread.join();
+    }
+    m_Threads.clear();
+    m_Decoded.notify_all();
+}
+
+void TextureLoader::BuildMips(Image* image) {
+    const int channels = image->Channels;
+
+    std::size_t size = 0;
+    for (int width = image->Width, height = image->Height; width > 1 || height > 1;) {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        size += static_cast<std::size_t>(width) * height * channels;
+    }
+    image->Mips.resize(size);
+
+    // Box filter, odd row or column is folded into the previous one by clamping
+    const unsigned char* source = image->Pixels;
+    unsigned char* destination = image->Mips.data();
+    int source_width = image->Width;
+    int source_height = image->Height;
+    while (source_width > 1 || source_height > 1) {
+        int width = std::max(1, source_width / 2);
+        int height = std::max(1, source_height / 2);
+
+        for (int y = 0; y < height; y++) {
+            int y0 = std::min(2 * y, source_height - 1);
+            int y1 = std::min(2 * y + 1, source_height - 1);
+            for (int x = 0; x < width; x++) {
+                int x0 = std::min(2 * x, source_width - 1);
+                int x1 = std::min(2 * x + 1, source_width - 1);
+                for (int c = 0; c < channels; c++) {
+                    int sum = source[(y0 * source_width + x0) * channels + c] + source[(y0 * source_width + x1) * channels + c]
+                            + source[(y1 * source_width + x0) * channels + c] + source[(y1 * source_width + x1) * channels + c];
+                    destination[(y * width + x) * channels + c] = static_cast<unsigned char>((sum + 2) / 4);
+                }
+            }
+        }
+
+        source = destination;
+        destination += static_cast<std::size_t>(width) * height * channels;
+        source_width = width;
+        source_height = height;
+    }
+}
+
+bool TextureLoader::Prepare(Request* request) const {
+    // Levels of cached texture were listed by worker
+    if (request->Cached) {
+        return true;
+    }
+
+    bool valid = true;
+    for (const Image& face : request->Faces) {
+        if (face.Pixels == nullptr) {
+            if (request->Target == GL_TEXTURE_CUBE_MAP) {
+                std::cout << "Cubemap texture failed to load at path: " << face.Path << '\n';
+            } else {
+                std::cout << "Texture failed to load at path: " << face.Path << '\n';
+            }
+            valid = false;
+        }
+    }
+    if (!valid) {
+        return false;
+    }
+
+    // Faces of cubemap have to be squares of the same size
+    if (request->Target == GL_TEXTURE_CUBE_MAP) {
+        for (const Image& face : request->Faces) {
+            if (face.Width != face.Height || face.Width != request->Faces[0].Width) {
+                std::cout << "Cubemap texture has mismatched size at path: " << face.Path << '\n';
+                return false;
+            }
+        }
+    }
+
+    request->Levels.clear();
+    for (std::size_t i = 0; i < request->Faces.size(); i++) {
+        const Image& face = request->Faces[i];
+
+        TextureCache::Level level;
+        level.Target = request->Target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(i) : GL_TEXTURE_2D;
+        level.Width = face.Width;
+        level.Height = face.Height;
+        level.InternalFormat = TextureCache::InternalFormat(face.Channels);
+        level.Format = TextureCache::Format(face.Channels);
+        level.Data = face.Pixels;
+        level.Size = face.Size();
+        request->Levels.push_back(level);
+
+        // Driver compresses every level as it is specified
+        const unsigned char* mip = face.Mips.data();
+        while (level.Width > 1 || level.Height > 1) {
+            level.Mip++;
+            level.Width = std::max(1, level.Width / 2);
+            level.Height = std::max(1, level.Height / 2);
+            level.Data = mip;
+            level.Size = static_cast<std::size_t>(level.Width) * level.Height * face.Channels;
+            mip += level.Size;
+            request->Levels.push_back(level);
+        }
+    }
+
+    return true;
+}
+
+void TextureLoader::Copy(const Request& request, std::size_t offset, std::size_t size, unsigned char* destination) const {
+    // Levels are laid out one after another, copy the part of each overlapping the slice
+    std::size_t level_offset = 0;
+    for (const TextureCache::Level& level : request.Levels) {
+        std::size_t level_end = level_offset + level.Size;
+        std::size_t begin = std::max(offset, level_offset);
+        std::size_t end = std::min(offset + size, level_end);
+        if (begin < end) {
+            std::memcpy(destination + (begin - offset), level.Data + (begin - level_offset), end - begin);
+        }
+        level_offset = level_end;
+    }
+}
+
+void TextureLoader::Complete(const Request& request, TextureHandle* texture) {
+    g_GLState.BindTexture(request.Target, request.Texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    // Source pointers are offsets into bound unpack buffer
+    std::size_t offset = 0;
+    GLint max_level = 0;
+    for (const TextureCache::Level& level : request.Levels) {
+        const void* data = reinterpret_cast<const void*>(offset);
+        if (level.Format == 0) {
+            glCompressedTexImage2D(level.Target, level.Mip, level.InternalFormat, level.Width, level.Height, 0, static_cast<GLsizei>(level.Size), data);
+        } else {
+            glTexImage2D(level.Target, level.Mip, level.InternalFormat, level.Width, level.Height, 0, level.Format, GL_UNSIGNED_BYTE, data);
+        }
+        offset += level.Size;
+        max_level = std::max(max_level, level.Mip);
+    }
+    // Placeholder is not worth counting
+    texture->Bytes(offset);
+    glTexParameteri(request.Target, GL_TEXTURE_MAX_LEVEL, max_level);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    if (!request.Cached) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        TextureCache::Store(request.Texture, request.Target, request.Levels.front().Format, request.CacheKey);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_UnpackBuffer);
+    }
+}
+
+void TextureLoader::Release(Request* request) {
+    for (Image& face : request->Faces) {
+        stbi_image_free(face.Pixels);
+        face.Pixels = nullptr;
+    }
+
+    m_Requests.remove_if([request](const std::unique_ptr<Request>& owned) { return owned.get() == request; });
+}
@@ -0,0 +1,152 @@
+#ifndef TextureLoader_h
+#define TextureLoader_h
+
+#include "GLResources.h"
+#include "TextureCache.h"
+#include "../utilities/MappedFile.h"
+
+#pragma warning(push, 0)
+#include <glad/glad.h>
+#pragma warning(pop)
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Asynchronous texture loader
+ *
+ * Texture object is created right away holding 1x1 placeholder, so caller
+ * can use returned name immediately. Worker thread first looks for the
+ * texture in TextureCache and maps the entry if there is one. Otherwise
+ * images are decoded, every face of a cubemap as a separate job, and mip
+ * chain is built on the worker; such texture is written to the cache once
+ * uploaded. Data is copied on GL thread into pixel unpack buffer in slices
+ * of at most UPLOAD_BUDGET bytes per Update(), once all of it is in the
+ * buffer the texture gets its final content at once, so partially uploaded
+ * texture is never sampled. Textures are shared: requesting file that
+ * resolves to already requested one returns the same texture object.
+ * Loader owns the textures, every Load() has to be paired with Unload()
+ * and the texture is released once the last user unloads it.
+ */
+class TextureLoader {
+public:
+    // Bytes copied into unpack buffer per call of Update()
+    static constexpr std::size_t UPLOAD_BUDGET = 4 * 1024 * 1024;
+
+    TextureLoader() = default;
+    ~TextureLoader();
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+    TextureLoader(TextureLoader&&) = delete;
+    TextureLoader& operator=(TextureLoader&&) = delete;
+
+    // Has to be called with current context
+    void Initialize(unsigned int threads = std::max(1u, std::thread::hardware_concurrency() / 2));
+    void Destroy();
+
+    // 2D texture with mipmaps and repeat wrapping, memory of shared texture is accounted to its first owner
+    GLuint Load(const std::string& path, GLResources::Owner owner = GLResources::Owner::TEXTURES);
+    // Faces in order +X, -X, +Y, -Y, +Z, -Z
+    GLuint LoadCubemap(const std::array<std::string, 6>& faces, GLResources::Owner owner = GLResources::Owner::SKYBOX);
+    // Drops one user of texture returned by Load() or LoadCubemap(), unfinished upload of released texture is dropped
+    void Unload(GLuint texture);
+
+    // Continues uploads on GL thread, returns true if any texture got its final content
+    bool Update(std::size_t budget = UPLOAD_BUDGET);
+    // Blocks until every requested texture is uploaded
+    void Finish();
+
+    bool Busy() const { return !m_Requests.empty(); }
+    std::size_t Pending() const { return m_Requests.size(); }
+    // Distinct texture objects created so far
+    std::size_t Loaded() const { return m_Loaded.size(); }
+
+private:
+    struct Image {
+        std::string Path;
+        unsigned char* Pixels{ nullptr };
+        int Width{ 0 };
+        int Height{ 0 };
+        int Channels{ 0 };
+        std::vector<unsigned char> Mips;    // Levels from 1 down to 1x1, one after another
+
+        std::size_t Size() const { return static_cast<std::size_t>(Width) * Height * Channels; }
+    };
+
+    struct Entry {
+        TextureHandle Texture;
+        std::size_t Users{ 0 };
+    };
+
+    struct Request {
+        std::string Key;
+        GLuint Texture{ 0 };
+        GLenum Target{ GL_TEXTURE_2D };
+        GLResources::Owner Owner{ GLResources::Owner::TEXTURES };
+        std::vector<Image> Faces;
+        std::size_t Remaining{ 0 };    // Jobs not yet finished, guarded by mutex
+
+        std::uint64_t CacheKey{ 0 };
+        MappedFile Cached;
+        std::vector<TextureCache::Level> Levels;
+    };
+
+    // Job looking up the cache instead of decoding a face
+    static constexpr std::size_t CACHED = static_cast<std::size_t>(-1);
+
+    struct Job {
+        Request* ToDecode{ nullptr };
+        std::size_t Face{ 0 };
+    };
+
+    // Path with ".", ".." and links resolved, so one file has one key however it is referenced
+    static std::string Resolve(const std::string& path);
+
+    static TextureHandle CreatePlaceholder(GLenum target, GLResources::Owner owner);
+    GLuint Add(std::string key, std::unique_ptr<Request> request);
+    // Texture the request uploads into, null if it was unloaded meanwhile
+    Entry* Find(const Request& request);
+    void Enqueue(std::unique_ptr<Request> request);
+    void WorkerLoop();
+    void StopThreads();
+
+    static void BuildMips(Image* image);
+
+    // Checks decoded faces and lists their levels, prints errors and returns false if request cannot be uploaded
+    bool Prepare(Request* request) const;
+    void Copy(const Request& request, std::size_t offset, std::size_t size, unsigned char* destination) const;
+    void Complete(const Request& request, TextureHandle* texture);
+    void Release(Request* request);
+
+    std::vector<std::thread> m_Threads;
+    std::mutex m_Mutex;
+    std::condition_variable m_JobReady;
+    std::condition_variable m_Decoded;
+    std::deque<Job> m_Jobs;
+    std::deque<Request*> m_Ready;
+    bool m_Stopping{ false };
+
+    // Following are touched only by GL thread
+    std::unordered_map<std::string, Entry> m_Loaded;
+    std::list<std::unique_ptr<Request>> m_Requests;
+    GLuint m_UnpackBuffer{ 0 };
+    Request* m_Uploading{ nullptr };
+    std::size_t m_UploadSize{ 0 };
+    std::size_t m_Uploaded{ 0 };
+    std::size_t m_UnpackBytes{ 0 };    // Storage of unpack buffer accounted to g_GLResources
+};
+
+extern TextureLoader g_TextureLoader;
+
+#endif
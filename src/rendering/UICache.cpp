@@ -0,0 +1,39 @@
+#include "UICache.h"
+
+UICache::~UICache() {
+    Clear();
+}
+
+bool UICache::Valid(unsigned int width, unsigned int height, std::uint64_t font_generation) const {
+    return m_Valid && m_Width == width && m_Height == height && m_FontGeneration == font_generation;
+}
+
+void UICache::Store(const ImDrawData& draw_data, unsigned int width, unsigned int height, std::uint64_t font_generation) {
+    Clear();
+
+    // Lists of the frame are reused by ImGui next frame, so they are cloned
+    for (int i = 0; i < draw_data.CmdListsCount; i++) {
+        m_Lists.push_back(draw_data.CmdLists[i]->CloneOutput());
+    }
+
+    m_DrawData = draw_data;
+    m_DrawData.CmdLists = m_Lists.data();
+    m_Width = width;
+    m_Height = height;
+    m_FontGeneration = font_generation;
+    m_Valid = draw_data.Valid;
+}
+
+void UICache::Clear() {
+    for (ImDrawList* list : m_Lists) {
+        IM_DELETE(list);
+    }
+    m_Lists.clear();
+    m_DrawData = ImDrawData();
+    m_Valid = false;
+}
+
+ImDrawData* UICache::Replay() {
+    m_Replayed++;
+    return &m_DrawData;
+}
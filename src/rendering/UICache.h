@@ -0,0 +1,50 @@
+#ifndef UICache_h
+#define UICache_h
+
+#pragma warning(push, 0)
+#include <imgui.h>
+#pragma warning(pop)
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * UI cache
+ *
+ * Keeps copy of the last built Dear ImGui draw data. While no widget
+ * changed and there is no input, DrawManager submits the copy again
+ * instead of running ImGui frame, so static UI costs one RenderDrawData
+ * call. Copy is valid only for the window size and font atlas it was built
+ * with, atlas texture is referenced by its draw commands.
+ */
+class UICache {
+public:
+    UICache() = default;
+    ~UICache();
+    UICache(const UICache&) = delete;
+    UICache& operator=(const UICache&) = delete;
+    UICache(UICache&&) = delete;
+    UICache& operator=(UICache&&) = delete;
+
+    bool Valid(unsigned int width, unsigned int height, std::uint64_t font_generation) const;
+
+    // Replaces cached copy by clone of draw lists
+    void Store(const ImDrawData& draw_data, unsigned int width, unsigned int height, std::uint64_t font_generation);
+    void Clear();
+
+    // Counts the replay, valid until next Store or Clear
+    ImDrawData* Replay();
+
+    std::uint64_t Replayed() const { return m_Replayed; }
+
+private:
+    bool m_Valid{ false };
+    ImDrawData m_DrawData;
+    std::vector<ImDrawList*> m_Lists;
+    unsigned int m_Width{ 0 };
+    unsigned int m_Height{ 0 };
+    std::uint64_t m_FontGeneration{ 0 };
+    std::uint64_t m_Replayed{ 0 };
+};
+
+#endif
@@ -1,6 +1,14 @@
 #include "Scene.h"
 #include <enet/enet.h>
 
+#pragma warning(push, 0)
+#include <stb_image_write.h>
+#pragma warning(pop)
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <iomanip>
 #include <iostream>
 
 #include "../client_server_shared/drawing_snapshot.hpp"
@@ -8,6 +16,9 @@
 
 #include "../rendering/Drawable.h"
 #include "../rendering/ILightSource.h"
+#include "../rendering/GLResources.h"
+#include "../rendering/GLState.h"
+#include "../rendering/TextureLoader.h"
 
 void MyScene::PreRun() {
     m_Running = true;
@@ -78,12 +89,19 @@ void MyScene::Run() {
     }
 
     // Game loop
+    bool idle = false;
     while (m_Running && !glfwWindowShouldClose(g_Window)) {
-        // If frame rate is greater than limit then wait
-        do {
-            g_Time.Hold();
+        if (idle) {
+            // Nothing changed last frame, loop sleeps in ENet below so snapshots are not held back by window events
             glfwPollEvents();
-        } while (g_Time.DeltaTime() < m_FrameRateLimit);
+            g_Time.Hold();
+        } else {
+            // If frame rate is greater than limit then wait
+            do {
+                g_Time.Hold();
+                glfwPollEvents();
+            } while (g_Time.DeltaTime() < m_FrameRateLimit);
+        }
         
         // Update global systems
         g_Time.Update();
@@ -91,15 +109,52 @@ void MyScene::Run() {
         InputSnapshot input_snapshot = g_Input.NetworkUpdate(g_Window);
         input_snapshot.client_id = client_id;
 
+        if (g_Input.Active()) {
+            m_DrawManager.Invalidate();
+        }
+
+        if (g_Input.KeyPressed(GLFW_KEY_F3)) {
+            m_DrawManager.ShowStatistics(!m_DrawManager.ShowStatistics());
+        }
+
+        if (g_Input.KeyPressed(GLFW_KEY_F4)) {
+            m_DrawManager.ShowBounds(!m_DrawManager.ShowBounds());
+        }
+
+        if (g_Input.KeyPressed(GLFW_KEY_F5)) {
+            m_DrawManager.ShowMemory(!m_DrawManager.ShowMemory());
+        }
+
+        if (g_Input.KeyPressed(GLFW_KEY_F6)) {
+            DumpMemory();
+        }
+
+        if (g_Input.KeyPressed(GLFW_KEY_F10)) {
+            if (m_DrawManager.Capture().Recording()) {
+                m_DrawManager.Capture().StopRecording();
+            } else {
+                Record("recording_" + std::to_string(std::time(nullptr)) + ".y4m");
+            }
+        }
+
+        if (g_Input.KeyPressed(GLFW_KEY_F12)) {
+            m_DrawManager.Capture().Screenshot("screenshot_" + std::to_string(std::time(nullptr)) + ".png");
+            m_DrawManager.Invalidate();
+        }
+
         // std::cout << input_snapshot.enter_pressed << ' ' << input_snapshot.shift_pressed << std::endl;
 
-        while (enet_host_service(client, &event, m_FrameRateLimit) > 0) {
+        bool drawn = false;
+        // Snapshot from server ends idle wait right away, timeout only bounds latency of input
+        enet_uint32 timeout = idle ? IDLE_TIMEOUT : static_cast<enet_uint32>(m_FrameRateLimit);
+        while (enet_host_service(client, &event, timeout) > 0) {
+            timeout = static_cast<enet_uint32>(m_FrameRateLimit);
             switch (event.type) {
                 case ENET_EVENT_TYPE_RECEIVE:
                 {
                     DrawingSnapshot drawing_snapshot;
                     memcpy(&drawing_snapshot, event.packet->data, sizeof(DrawingSnapshot));
-                    m_DrawManager.NetworkCallDraws(&drawing_snapshot);
+                    drawn = m_DrawManager.NetworkCallDraws(&drawing_snapshot) || drawn;
                     enet_packet_destroy(event.packet);
                 }
                     break;
@@ -119,13 +174,104 @@ void MyScene::Run() {
 
         enet_host_flush(client);
 
+        // Keep polling while textures are being loaded, finished ones redraw the frame
+        idle = !drawn && !g_TextureLoader.Busy();
+
         // m_ObjectManager.ProcessFrame(); 
         // m_DrawManager.CallDraws();
     }
 }
 
+void MyScene::RunHeadless(unsigned int frames, const std::vector<unsigned int>& dumped_frames, const std::string& dump_prefix) {
+    m_ObjectManager.InitializeObjects();
+    m_DrawManager.Offscreen(g_Window.Width(), g_Window.Height());
+
+    // Measured frames should not include uploads nor show placeholders
+    g_TextureLoader.Finish();
+
+    g_Time.Initialize();
+
+    std::vector<double> frame_times;
+    frame_times.reserve(frames);
+    std::vector<unsigned char> pixels;
+
+    for (unsigned int frame = 0; frame < frames && m_Running; frame++) {
+        double frame_start = glfwGetTime();
+
+        glfwPollEvents();
+        g_Time.Update();
+        g_Input.Update(g_Window);
+
+        m_ObjectManager.ProcessFrame();
+
+        // Benchmark measures every frame, even unchanged ones
+        m_DrawManager.Invalidate();
+        m_DrawManager.CallDraws();
+
+        // Wait for GPU so that frame time covers whole frame
+        glFinish();
+        frame_times.push_back(glfwGetTime() - frame_start);
+
+        if (std::find(dumped_frames.begin(), dumped_frames.end(), frame) != dumped_frames.end()) {
+            const Framebuffer* target = m_DrawManager.Offscreen();
+            target->ReadPixels(&pixels);
+
+            std::string path = dump_prefix + std::to_string(frame) + ".png";
+            stbi_flip_vertically_on_write(1);
+            if (!stbi_write_png(path.c_str(), target->Width(), target->Height(), 4, pixels.data(), target->Width() * 4)) {
+                std::cout << "Frame failed to save at path: " << path << '\n';
+            }
+        }
+    }
+
+    if (frame_times.empty()) {
+        return;
+    }
+
+    // Frame time statistics in milliseconds
+    std::vector<double> sorted = frame_times;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&](double p) { return sorted[static_cast<std::size_t>(p * (sorted.size() - 1))] * 1000.0; };
+
+    double total = 0.0;
+    for (double frame_time : frame_times) {
+        total += frame_time;
+    }
+    double mean = total / frame_times.size() * 1000.0;
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "Headless: " << frame_times.size() << " frames at " << g_Window.Width() << 'x' << g_Window.Height() << '\n'
+              << "  frame time [ms] min " << sorted.front() * 1000.0 << ", mean " << mean << ", median " << percentile(0.5)
+              << ", p99 " << percentile(0.99) << ", max " << sorted.back() * 1000.0 << '\n'
+              << "  " << 1000.0 / mean << " frames per second\n";
+}
+
 void MyScene::PostRun() {
     m_ObjectManager.DestroyObjects();
+    // Context is still current, objects released by components are deleted now
+    g_GLResources.Collect();
+
+    m_DrawManager.Capture().Finish();
+    if (!m_PrintStatistics) {
+        return;
+    }
+
+    FrameCapture::Statistics capture = m_DrawManager.Capture().Stats();
+    if (capture.Captured > 0) {
+        std::cout << "Frame capture: " << capture.Captured << " frames read back, " << capture.Written << " recorded, "
+                  << capture.DroppedGpu << " dropped waiting for GPU, " << capture.DroppedWriter << " dropped waiting for writer\n";
+    }
+
+    std::cout << "GL state cache: " << g_GLState.Issued() << " calls issued, "
+              << g_GLState.Skipped() << " redundant calls skipped\n";
+    std::cout << "Frustum culling: " << m_DrawManager.Culling().Visible << " drawables visible, "
+              << m_DrawManager.Culling().Culled << " culled in last frame\n";
+    std::cout << "Idle mode: " << m_DrawManager.SkippedFrames() << " unchanged frames skipped\n";
+    for (int pass = 0; pass < GPUTimers::Pass::COUNT; pass++) {
+        GPUTimers::Timing timing = m_DrawManager.PassTiming(static_cast<GPUTimers::Pass>(pass));
+        std::cout << "GPU " << GPUTimers::Name(static_cast<GPUTimers::Pass>(pass)) << " pass: "
+                  << timing.Average << " ms average, " << timing.P99 << " ms p99\n";
+    }
 }
 
 void MyScene::Exit() {
@@ -136,6 +282,18 @@ void MyScene::FrameRateLimit(unsigned int frame_rate) {
     m_FrameRateLimit = frame_rate != 0 ? 1.0f / (float)frame_rate : 0.0f;
 }
 
+void MyScene::DumpMemory() const {
+    g_GLResources.Dump(std::cout);
+}
+
+void MyScene::Record(const std::string& path) {
+    bool stream = path.size() >= 4 && path.compare(path.size() - 4, 4, ".y4m") == 0;
+    unsigned int frame_rate = m_FrameRateLimit > 0.0f ? static_cast<unsigned int>(std::lround(1.0f / m_FrameRateLimit)) : 60;
+
+    m_DrawManager.Capture().StartRecording(path, stream ? FrameCapture::Format::Y4M : FrameCapture::Format::PNG, frame_rate);
+    std::cout << "Recording into: " << path << '\n';
+}
+
 MyObject* MyScene::CreateObject(std::string name) {
     return m_ObjectManager.CreateObject(name);
 }
@@ -183,3 +341,11 @@ void MyScene::Skybox(const std::string& right, const std::string& left, const st
 void MyScene::Background(const glm::vec3& background) {
     m_DrawManager.Background(background);
 }
+
+void MyScene::Depth(DrawManager::DepthStrategy strategy) {
+    m_DrawManager.Depth(strategy);
+}
+
+void MyScene::ResolutionScaling(float min_scale, float max_scale, float target_frame_rate) {
+    m_DrawManager.ResolutionScaling(min_scale, max_scale, target_frame_rate);
+}
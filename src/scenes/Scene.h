@@ -7,6 +7,9 @@
 #include "../utilities/Input.h"
 #include "../utilities/Window.h"
 
+#include <string>
+#include <vector>
+
 class MyScene {
 public:
     MyScene() = default;
@@ -20,10 +23,19 @@ public:
 
     void PreRun();
     void Run();
+    // Draws given number of frames locally into offscreen framebuffer, without server
+    void RunHeadless(unsigned int frames, const std::vector<unsigned int>& dumped_frames, const std::string& dump_prefix);
+    // Prints rendering statistics of the run when asked to
     void PostRun();
 
     void Exit();
     void FrameRateLimit(unsigned int frame_rate);
+    // Records every drawn frame, ".y4m" path gets a single stream, anything else is prefix of numbered PNG files
+    void Record(const std::string& path);
+    // Prints GPU memory accounts, totals, high-water marks and owners
+    void DumpMemory() const;
+    bool PrintStatistics() const { return m_PrintStatistics; }
+    void PrintStatistics(bool print) { m_PrintStatistics = print; }
     float FrameRate() const { return 1.0f / g_Time.DeltaTime(); }
 
     // ObjectManger functions
@@ -41,13 +53,19 @@ public:
     Camera* MainCamera() const;
     void Skybox(const std::string& right, const std::string& left, const std::string& top, const std::string& bottom, const std::string& back, const std::string& front);
     void Background(const glm::vec3& background);
+    void Depth(DrawManager::DepthStrategy strategy);
+    void ResolutionScaling(float min_scale, float max_scale, float target_frame_rate);
 
 private:
+    // Longest wait for server while nothing changes, in milliseconds
+    static constexpr unsigned int IDLE_TIMEOUT = 16;
+
     ObjectManager m_ObjectManager{ *this };
     DrawManager m_DrawManager{ };
 
     bool m_Running{ false };
     float m_FrameRateLimit{ 0.0f };
+    bool m_PrintStatistics{ false };
 };
 
 #endif
@@ -0,0 +1,41 @@
+#ifndef Hash_h
+#define Hash_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+constexpr std::uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+constexpr std::uint64_t FNV_PRIME = 1099511628211ull;
+
+// 64 bit FNV-1a, pass previous result as hash to combine several inputs
+inline std::uint64_t Fnv1a(const void* data, std::size_t size, std::uint64_t hash = FNV_OFFSET_BASIS) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+inline std::uint64_t Fnv1a(const std::string& text, std::uint64_t hash = FNV_OFFSET_BASIS) {
+    // Length is hashed too, so that "ab" + "c" and "a" + "bc" differ
+    std::uint64_t size = text.size();
+    hash = Fnv1a(&size, sizeof(size), hash);
+    return Fnv1a(text.data(), text.size(), hash);
+}
+
+inline std::string HashToHex(std::uint64_t hash) {
+    static const char digits[] = "0123456789abcdef";
+
+    std::string hex(16, '0');
+    for (int i = 15; i >= 0; i--) {
+        hex[i] = digits[hash & 0xF];
+        hash >>= 4;
+    }
+
+    return hex;
+}
+
+#endif
@@ -99,6 +99,11 @@ InputSnapshot Input::NetworkUpdate(GLFWwindow *window) {
     return input_snapshot;
 }
 
+bool Input::Active() const {
+    return m_AnyKeyPressed || m_AnyKeyHold || m_AnyKeyReleased
+        || m_MouseOffset != glm::vec2(0.0f) || m_ScrollOffset != 0.0f;
+}
+
 bool Input::KeyPressed(int glfw_key_enum) const {
     return m_Keys[glfw_key_enum] == EKeyState::PRESSED;
 }
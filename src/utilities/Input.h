@@ -31,6 +31,8 @@ public:
     bool AnyKeyPressed() const { return m_AnyKeyPressed; }
     bool AnyKeyHold() const { return m_AnyKeyHold; }
     bool AnyKeyReleased() const { return m_AnyKeyReleased; }
+    // True if anything changed or is being held since last update
+    bool Active() const;
     bool KeyPressed(int glfw_key_enum) const;
     bool KeyHold(int glfw_key_enum) const ;
     bool KeyReleased(int glfw_key_enum) const ;
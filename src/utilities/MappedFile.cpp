@@ -0,0 +1,110 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        Close();
+
+        m_Data = std::exchange(other.m_Data, nullptr);
+        m_Size = std::exchange(other.m_Size, 0);
+#ifdef _WIN32
+        m_File = std::exchange(other.m_File, nullptr);
+        m_Mapping = std::exchange(other.m_Mapping, nullptr);
+#endif
+    }
+
+    return *this;
+}
+
+bool MappedFile::Open(const std::string& path) {
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_File = file;
+    m_Mapping = mapping;
+    m_Data = static_cast<const unsigned char*>(data);
+    m_Size = static_cast<std::size_t>(size.QuadPart);
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file == -1) {
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(file, &status) == -1 || status.st_size == 0) {
+        close(file);
+        return false;
+    }
+
+    // Mapping stays valid after the descriptor is closed
+    void* data = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    m_Data = static_cast<const unsigned char*>(data);
+    m_Size = static_cast<std::size_t>(status.st_size);
+#endif
+
+    return true;
+}
+
+void MappedFile::Close() {
+    if (m_Data == nullptr) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(m_Data);
+    CloseHandle(m_Mapping);
+    CloseHandle(m_File);
+    m_File = nullptr;
+    m_Mapping = nullptr;
+#else
+    munmap(const_cast<unsigned char*>(m_Data), m_Size);
+#endif
+
+    m_Data = nullptr;
+    m_Size = 0;
+}
@@ -0,0 +1,42 @@
+#ifndef MappedFile_h
+#define MappedFile_h
+
+#include <cstddef>
+#include <string>
+
+/**
+ * Memory mapped file
+ *
+ * Read only view of whole file, pages are loaded by the OS on first access
+ * instead of being copied into a buffer up front. Mapping is released when
+ * the object is closed or destroyed.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path) { Open(path); }
+    ~MappedFile() { Close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Returns false if file does not exist, is empty or cannot be mapped
+    bool Open(const std::string& path);
+    void Close();
+
+    const unsigned char* Data() const { return m_Data; }
+    std::size_t Size() const { return m_Size; }
+
+    explicit operator bool() const { return m_Data != nullptr; }
+
+private:
+    const unsigned char* m_Data{ nullptr };
+    std::size_t m_Size{ 0 };
+#ifdef _WIN32
+    void* m_File{ nullptr };
+    void* m_Mapping{ nullptr };
+#endif
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int size)
+    // hardware_concurrency may return zero when it cannot be determined
+    : m_Size(size > 1 ? size : 1) {
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_WorkReady.notify_all();
+
+    for (std::thread& thread : m_Threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::ParallelFor(std::size_t count, const Job_t& job) {
+    if (count == 0) {
+        return;
+    }
+
+    if (m_Size == 1) {
+        job(0, count, 0);
+        return;
+    }
+
+    // Workers start waiting for the generation after the current one
+    while (m_Threads.size() + 1 < m_Size) {
+        m_Threads.emplace_back(&ThreadPool::WorkerLoop, this, static_cast<unsigned int>(m_Threads.size()), m_Generation);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Job = &job;
+        m_Count = count;
+        m_Pending = static_cast<unsigned int>(m_Threads.size());
+        m_Error = nullptr;
+        m_Generation++;
+    }
+    m_WorkReady.notify_all();
+
+    // Calling thread handles the last range
+    RunRange(Size() - 1);
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_WorkDone.wait(lock, [this]() { return m_Pending == 0; });
+        m_Job = nullptr;
+        error = m_Error;
+        m_Error = nullptr;
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::WorkerLoop(unsigned int worker, std::size_t generation) {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WorkReady.wait(lock, [&]() { return m_Stopping || m_Generation != generation; });
+            if (m_Stopping) {
+                return;
+            }
+            generation = m_Generation;
+        }
+
+        RunRange(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Pending--;
+        }
+        m_WorkDone.notify_one();
+    }
+}
+
+void ThreadPool::RunRange(unsigned int worker) {
+    std::size_t begin = m_Count * worker / Size();
+    std::size_t end = m_Count * (worker + 1) / Size();
+    if (begin >= end) {
+        return;
+    }
+
+    // Failed range still counts as done, otherwise caller would wait forever
+    try {
+        (*m_Job)(begin, end, worker);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (!m_Error) {
+            m_Error = std::current_exception();
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef ThreadPool_h
+#define ThreadPool_h
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Thread pool
+ *
+ * Fixed set of worker threads running one range job at a time. Calling
+ * thread takes part in the work as the last worker, so pool of size one
+ * owns no threads and runs everything serially. Threads are started by
+ * the first parallel job, pools that never get one cost nothing. First
+ * exception thrown by a job is rethrown on calling thread once all ranges
+ * are done.
+ */
+class ThreadPool {
+public:
+    using Job_t = std::function<void(std::size_t begin, std::size_t end, unsigned int worker)>;
+
+    explicit ThreadPool(unsigned int size = std::thread::hardware_concurrency());
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    // Number of workers including calling thread
+    unsigned int Size() const { return m_Size; }
+
+    // Splits [0, count) into contiguous ranges, one per worker, and blocks until all are done,
+    // workers whose range is empty are not called
+    void ParallelFor(std::size_t count, const Job_t& job);
+
+private:
+    void WorkerLoop(unsigned int worker, std::size_t generation);
+    void RunRange(unsigned int worker);
+
+    unsigned int m_Size;
+    std::vector<std::thread> m_Threads;
+    std::mutex m_Mutex;
+    std::condition_variable m_WorkReady;
+    std::condition_variable m_WorkDone;
+
+    const Job_t* m_Job{ nullptr };
+    std::size_t m_Count{ 0 };
+    std::size_t m_Generation{ 0 };
+    unsigned int m_Pending{ 0 };
+    std::exception_ptr m_Error;
+    bool m_Stopping{ false };
+};
+
+#endif